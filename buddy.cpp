@@ -1,125 +1,847 @@
-
 #include <iostream>
 #include <vector>
-#include <list>
 #include <unordered_map>
+#include <queue>
 #include <fstream>
-#include <cmath>
+#include <cstdint>
+#include <cstring>
+#include <cstdlib>
+#include <algorithm>
+#include <string>
+#include <random>
+#include <chrono>
+#include <memory_resource>
+#include <new>
+#include <mutex>
+#include <thread>
+#include <iomanip>
+#include <charconv>
+#include <cstdio>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <fcntl.h>
+#include <unistd.h>
 
 
 struct Block {
-    int size;
-    int start;
+    long size;
+    long start;
 };
 
 
 struct Allocation {
     int process_id;
-    int size;
+    long size;
+    long start;
+    int order;
     int end_time;
 };
 
 
-const int MAX_ORDER = 10;  
-std::vector<std::list<Block>> free_list(MAX_ORDER + 1);
-std::unordered_map<int, Allocation> active_allocations;
+// One bit per block of a given order. Each upper level holds one bit per
+// non-zero word of the level below, so the first free block is found by
+// descending from a single top word with find-first-set.
+struct OrderBitmap {
+    std::vector<std::vector<uint64_t>> levels;
+    size_t nbits = 0;
+
+    void init(size_t bits) {
+        nbits = bits;
+        levels.clear();
+        size_t words = (bits + 63) / 64;
+        do {
+            levels.emplace_back(words ? words : 1, 0);
+            words = (words + 63) / 64;
+        } while (levels.back().size() > 1);
+    }
+
+    bool empty() const {
+        return levels.back()[0] == 0;
+    }
+
+    bool test(size_t i) const {
+        return i < nbits && (levels[0][i >> 6] >> (i & 63) & 1);
+    }
+
+    void set(size_t i) {
+        for (auto& level : levels) {
+            uint64_t& word = level[i >> 6];
+            bool was_empty = word == 0;
+            word |= 1ULL << (i & 63);
+            if (!was_empty) break;
+            i >>= 6;
+        }
+    }
+
+    void clear(size_t i) {
+        for (auto& level : levels) {
+            uint64_t& word = level[i >> 6];
+            word &= ~(1ULL << (i & 63));
+            if (word != 0) break;
+            i >>= 6;
+        }
+    }
+
+    long find_first() const {
+        if (empty()) return -1;
+        size_t i = 0;
+        for (size_t l = levels.size(); l-- > 0;) {
+            i = (i << 6) | __builtin_ctzll(levels[l][i]);
+        }
+        return i;
+    }
+};
 
 
+const int MAX_ORDER = 10;
 
 
-void init_memory(int total_memory) {
-    int order = std::log2(total_memory);
-    free_list[order].push_back({total_memory, 0});
+int find_order(long units) {
+    return units <= 1 ? 0 : 64 - __builtin_clzll((unsigned long long)units - 1);
 }
 
 
-int find_order(int units) {
-    return std::ceil(std::log2(units));
+// Buddy allocator over an mmap'd arena of total_units blocks of unit_bytes.
+// The unit-level interface (allocate_block/free_block) is what the simulator
+// drives; the memory_resource interface hands out real pointers into the arena.
+class BuddyAllocator : public std::pmr::memory_resource {
+public:
+    BuddyAllocator(long total_units, size_t unit_bytes = 1, int max_order = MAX_ORDER)
+        : total_units_(total_units), unit_bytes_(unit_bytes), max_order_(max_order),
+          free_map_(max_order + 1) {
+        arena_bytes_ = total_units * unit_bytes;
+        void* p = mmap(nullptr, arena_bytes_, PROT_READ | PROT_WRITE,
+                       MAP_PRIVATE | MAP_ANONYMOUS | MAP_NORESERVE, -1, 0);
+        if (p == MAP_FAILED) throw std::bad_alloc();
+        base_ = static_cast<char*>(p);
+
+        for (int order = 0; order <= max_order_; ++order) {
+            free_map_[order].init(total_units >> order);
+        }
+
+        // Carve the region into the largest aligned blocks that fit
+        long start = 0;
+        for (int order = max_order_; order >= 0; --order) {
+            while (start + (1L << order) <= total_units) {
+                put_free(order, start);
+                start += 1L << order;
+            }
+        }
+    }
+
+    ~BuddyAllocator() override {
+        munmap(base_, arena_bytes_);
+    }
+
+    BuddyAllocator(const BuddyAllocator&) = delete;
+    BuddyAllocator& operator=(const BuddyAllocator&) = delete;
+
+    // Returns the start unit of a free 2^order block, or -1 if none is left
+    long allocate_block(int order) {
+        uint64_t candidates = order <= max_order_ ? free_orders_ & (~0ULL << order) : 0;
+        if (candidates == 0) return -1;
+
+        int i = __builtin_ctzll(candidates);
+        long start = free_map_[i].find_first() << i;
+        take_free(i, start);
+
+        while (i > order) {
+            --i;
+            put_free(i, start + (1L << i));
+        }
+        return start;
+    }
+
+    void free_block(long start, int order) {
+        while (order < max_order_) {
+            long buddy = start ^ (1L << order);
+            if (!free_map_[order].test(buddy >> order)) break;
+            take_free(order, buddy);
+            start &= ~(1L << order);
+            ++order;
+        }
+        put_free(order, start);
+    }
+
+    // Blocks are naturally aligned to their own size relative to the
+    // page-aligned base, so stronger alignment only needs a larger order.
+    int order_for(size_t bytes, size_t alignment = alignof(std::max_align_t)) const {
+        size_t units = (bytes + unit_bytes_ - 1) / unit_bytes_;
+        size_t align_units = (alignment + unit_bytes_ - 1) / unit_bytes_;
+        return find_order(std::max<size_t>({units, align_units, 1}));
+    }
+
+    char* base() const { return base_; }
+    size_t unit_bytes() const { return unit_bytes_; }
+    long total_units() const { return total_units_; }
+
+private:
+    void put_free(int order, long start) {
+        free_map_[order].set(start >> order);
+        free_orders_ |= 1ULL << order;
+    }
+
+    void take_free(int order, long start) {
+        free_map_[order].clear(start >> order);
+        if (free_map_[order].empty()) {
+            free_orders_ &= ~(1ULL << order);
+        }
+    }
+
+    void* do_allocate(size_t bytes, size_t alignment) override {
+        long start = allocate_block(order_for(bytes, alignment));
+        if (start < 0) throw std::bad_alloc();
+        return base_ + start * unit_bytes_;
+    }
+
+    void do_deallocate(void* p, size_t bytes, size_t alignment) override {
+        long start = (static_cast<char*>(p) - base_) / unit_bytes_;
+        free_block(start, order_for(bytes, alignment));
+    }
+
+    bool do_is_equal(const std::pmr::memory_resource& other) const noexcept override {
+        return this == &other;
+    }
+
+    long total_units_;
+    size_t unit_bytes_;
+    int max_order_;
+    size_t arena_bytes_ = 0;
+    char* base_ = nullptr;
+    std::vector<OrderBitmap> free_map_;
+    uint64_t free_orders_ = 0;  // bit k set while free_map_[k] is non-empty
+};
+
+
+
+// Thread-safe front end: the central BuddyAllocator sits behind one lock,
+// and each thread keeps magazines of free small-order blocks that are
+// refilled and drained half a magazine at a time, so most small
+// allocations never touch the lock. Blocks parked in a magazine do not
+// coalesce until they are drained back.
+class ConcurrentBuddy {
+public:
+    static const int MAGAZINE_ORDERS = 4;
+    static const int MAGAZINE_SIZE = 64;
+
+    ConcurrentBuddy(long total_units, size_t unit_bytes, int max_order)
+        : central_(total_units, unit_bytes, max_order) {}
+
+    // Per-thread handle; must not outlive its ConcurrentBuddy
+    class ThreadCache {
+    public:
+        explicit ThreadCache(ConcurrentBuddy& owner) : owner_(owner) {}
+
+        ~ThreadCache() {
+            for (int order = 0; order < MAGAZINE_ORDERS; ++order) {
+                owner_.drain(order, mags_[order].blocks, mags_[order].count);
+            }
+        }
+
+        ThreadCache(const ThreadCache&) = delete;
+        ThreadCache& operator=(const ThreadCache&) = delete;
+
+        void* allocate(size_t bytes) {
+            int order = owner_.central_.order_for(bytes);
+            long start;
+            if (order < MAGAZINE_ORDERS) {
+                Magazine& mag = mags_[order];
+                if (mag.count == 0) {
+                    mag.count = owner_.refill(order, mag.blocks, MAGAZINE_SIZE / 2);
+                    if (mag.count == 0) return nullptr;
+                }
+                start = mag.blocks[--mag.count];
+            } else {
+                start = owner_.allocate_central(order);
+                if (start < 0) return nullptr;
+            }
+            return owner_.central_.base() + start * owner_.central_.unit_bytes();
+        }
+
+        void deallocate(void* p, size_t bytes) {
+            int order = owner_.central_.order_for(bytes);
+            long start = (static_cast<char*>(p) - owner_.central_.base()) / owner_.central_.unit_bytes();
+            if (order < MAGAZINE_ORDERS) {
+                Magazine& mag = mags_[order];
+                if (mag.count == MAGAZINE_SIZE) {
+                    mag.count -= MAGAZINE_SIZE / 2;
+                    owner_.drain(order, mag.blocks + mag.count, MAGAZINE_SIZE / 2);
+                }
+                mag.blocks[mag.count++] = start;
+            } else {
+                owner_.free_central(start, order);
+            }
+        }
+
+    private:
+        struct Magazine {
+            long blocks[MAGAZINE_SIZE];
+            int count = 0;
+        };
+
+        ConcurrentBuddy& owner_;
+        Magazine mags_[MAGAZINE_ORDERS];
+    };
+
+    long allocate_central(int order) {
+        std::lock_guard<std::mutex> guard(lock_);
+        return central_.allocate_block(order);
+    }
+
+    void free_central(long start, int order) {
+        std::lock_guard<std::mutex> guard(lock_);
+        central_.free_block(start, order);
+    }
+
+    BuddyAllocator& central() { return central_; }
+
+private:
+    int refill(int order, long* out, int n) {
+        std::lock_guard<std::mutex> guard(lock_);
+        int got = 0;
+        while (got < n) {
+            long start = central_.allocate_block(order);
+            if (start < 0) break;
+            out[got++] = start;
+        }
+        return got;
+    }
+
+    void drain(int order, const long* blocks, int n) {
+        if (n == 0) return;
+        std::lock_guard<std::mutex> guard(lock_);
+        for (int i = 0; i < n; ++i) {
+            central_.free_block(blocks[i], order);
+        }
+    }
+
+    BuddyAllocator central_;
+    std::mutex lock_;
+};
+
+
+
+
+struct BuddySimulator {
+    BuddyAllocator memory;
+    // Live allocations are keyed by a sequence number rather than the
+    // process id, so a process id that comes back while its earlier block
+    // is still live gets a second allocation instead of replacing the first.
+    std::unordered_map<long, Allocation> active_allocations;
+    std::priority_queue<std::pair<int, long>, std::vector<std::pair<int, long>>,
+                        std::greater<std::pair<int, long>>> expiries;
+    long next_allocation = 0;
+    bool verbose = true;
+    size_t requests = 0;
+    size_t failures = 0;
+
+    explicit BuddySimulator(long total_memory, int max_order = MAX_ORDER)
+        : memory(total_memory, 1, max_order) {}
+
+
+    Block allocate(int process_id, int units, int current_time, int duration) {
+        int order = find_order(units);
+        long start = memory.allocate_block(order);
+        ++requests;
+        if (start < 0) {
+            ++failures;
+            if (verbose) std::cerr << "Memory allocation failed for Process " << process_id << "\n";
+            return {-1, -1};
+        }
+
+        Block block = {1L << order, start};
+        long allocation = next_allocation++;
+        active_allocations[allocation] = {process_id, block.size, start, order, current_time + duration};
+        expiries.push({current_time + duration, allocation});
+        if (verbose) std::cout << "Allocated " << block.size << " units to Process " << process_id << "\n";
+        return block;
+    }
+
+
+    void deallocate(long allocation) {
+        auto it = active_allocations.find(allocation);
+        if (it != active_allocations.end()) {
+            memory.free_block(it->second.start, it->second.order);
+            if (verbose) std::cout << "Deallocated Process " << it->second.process_id << "\n";
+            active_allocations.erase(it);
+        }
+    }
+
+
+    // Releases every allocation whose end time has passed, earliest first
+    void tick(int current_time) {
+        while (!expiries.empty() && expiries.top().first <= current_time) {
+            long allocation = expiries.top().second;
+            expiries.pop();
+            deallocate(allocation);
+        }
+    }
+};
+
+
+struct Request {
+    int process_id;
+    int units;
+    int request_time;
+    int duration;
+};
+
+
+// Read-only mapping of a whole file
+class MappedFile {
+public:
+    explicit MappedFile(const std::string& filename) {
+        int fd = open(filename.c_str(), O_RDONLY);
+        if (fd < 0) return;
+        struct stat st;
+        if (fstat(fd, &st) == 0 && st.st_size > 0) {
+            void* p = mmap(nullptr, st.st_size, PROT_READ, MAP_PRIVATE, fd, 0);
+            if (p != MAP_FAILED) {
+                data_ = static_cast<const char*>(p);
+                size_ = st.st_size;
+                madvise(p, size_, MADV_SEQUENTIAL);
+            }
+        }
+        ok_ = true;
+        close(fd);
+    }
+
+    ~MappedFile() {
+        if (data_) munmap(const_cast<char*>(data_), size_);
+    }
+
+    MappedFile(const MappedFile&) = delete;
+    MappedFile& operator=(const MappedFile&) = delete;
+
+    bool ok() const { return ok_; }
+    const char* data() const { return data_; }
+    size_t size() const { return size_; }
+
+private:
+    const char* data_ = nullptr;
+    size_t size_ = 0;
+    bool ok_ = false;
+};
+
+
+// Binary trace: 8-byte magic, little-endian uint64 record count, then one
+// fixed 16-byte record per request (four little-endian int32 fields in
+// Request order).
+const char TRACE_MAGIC[8] = {'B', 'U', 'D', 'D', 'Y', 'T', 'R', '1'};
+const size_t TRACE_HEADER_BYTES = 16;
+const size_t TRACE_RECORD_BYTES = 16;
+
+
+// Byte-wise so the file is little-endian on any host; compilers turn these
+// into plain loads and stores on little-endian machines.
+uint64_t load_le(const char* p, int bytes) {
+    uint64_t value = 0;
+    for (int i = bytes - 1; i >= 0; --i) value = value << 8 | (unsigned char)p[i];
+    return value;
 }
 
 
+void store_le(char* p, uint64_t value, int bytes) {
+    for (int i = 0; i < bytes; ++i, value >>= 8) p[i] = (char)(value & 0xff);
+}
 
 
-Block allocate(int process_id, int units, int current_time, int duration) {
-    int order = find_order(units);
-    for (int i = order; i <= MAX_ORDER; ++i) {
-        if (!free_list[i].empty()) {
-            Block block = free_list[i].front();
-            free_list[i].pop_front();
+// Streams requests out of a mapped trace in either format. next_batch()
+// decodes into the caller's buffer, so replay needs no per-record heap
+// allocation. The text format stops at the first record with a negative id.
+class TraceReader {
+public:
+    explicit TraceReader(const std::string& filename) : file_(filename) {
+        pos_ = file_.data();
+        end_ = pos_ + file_.size();
+        if (file_.size() >= TRACE_HEADER_BYTES && std::memcmp(pos_, TRACE_MAGIC, 8) == 0) {
+            uint64_t count = load_le(pos_ + 8, 8);
+            binary_ = true;
+            pos_ += TRACE_HEADER_BYTES;
+            end_ = pos_ + std::min<uint64_t>(count, (end_ - pos_) / TRACE_RECORD_BYTES) * TRACE_RECORD_BYTES;
+        }
+    }
 
+    bool ok() const { return file_.ok(); }
 
-            while (i > order) {
-                --i;
-                Block buddy = {block.size / 2, block.start + block.size / 2};
-                free_list[i].push_back(buddy);
-                block.size /= 2;
+    size_t next_batch(Request* out, size_t max) {
+        if (binary_) {
+            size_t n = std::min<size_t>(max, (end_ - pos_) / TRACE_RECORD_BYTES);
+            for (size_t i = 0; i < n; ++i, pos_ += TRACE_RECORD_BYTES) {
+                out[i] = {(int32_t)load_le(pos_, 4), (int32_t)load_le(pos_ + 4, 4),
+                          (int32_t)load_le(pos_ + 8, 4), (int32_t)load_le(pos_ + 12, 4)};
+            }
+            return n;
+        }
+        size_t n = 0;
+        while (n < max && pos_ < end_) {
+            Request& r = out[n];
+            if (!parse_int(r.process_id) || r.process_id < 0 || !parse_int(r.units) ||
+                !parse_int(r.request_time) || !parse_int(r.duration)) {
+                pos_ = end_;
+                break;
             }
+            ++n;
+        }
+        return n;
+    }
+
+private:
+    bool parse_int(int& value) {
+        while (pos_ < end_ && (*pos_ == ' ' || *pos_ == '\t' || *pos_ == '\r' || *pos_ == '\n')) ++pos_;
+        auto [next, ec] = std::from_chars(pos_, end_, value);
+        if (ec != std::errc()) return false;
+        pos_ = next;
+        return true;
+    }
+
+    MappedFile file_;
+    const char* pos_ = nullptr;
+    const char* end_ = nullptr;
+    bool binary_ = false;
+};
 
 
-            active_allocations[process_id] = {process_id, block.size, current_time + duration};
-            std::cout << "Allocated " << block.size << " units to Process " << process_id << "\n";
-            return block;
+const size_t TRACE_BATCH = 4096;
+
+
+bool convert_trace(const std::string& input, const std::string& output) {
+    TraceReader reader(input);
+    FILE* out = std::fopen(output.c_str(), "wb");
+    if (!reader.ok() || !out) {
+        std::cerr << "Error: Could not convert " << input << " to " << output << "\n";
+        if (out) std::fclose(out);
+        return false;
+    }
+
+    uint64_t count = 0;
+    char header[TRACE_HEADER_BYTES] = {};
+    std::memcpy(header, TRACE_MAGIC, 8);
+    std::fwrite(header, 1, TRACE_HEADER_BYTES, out);
+
+    Request batch[TRACE_BATCH];
+    static char encoded[TRACE_BATCH * TRACE_RECORD_BYTES];
+    while (size_t n = reader.next_batch(batch, TRACE_BATCH)) {
+        for (size_t i = 0; i < n; ++i) {
+            char* record = encoded + i * TRACE_RECORD_BYTES;
+            store_le(record, (uint32_t)batch[i].process_id, 4);
+            store_le(record + 4, (uint32_t)batch[i].units, 4);
+            store_le(record + 8, (uint32_t)batch[i].request_time, 4);
+            store_le(record + 12, (uint32_t)batch[i].duration, 4);
         }
+        std::fwrite(encoded, TRACE_RECORD_BYTES, n, out);
+        count += n;
     }
-    std::cerr << "Memory allocation failed for Process " << process_id << "\n";
-    return {-1, -1};  
+
+    store_le(header + 8, count, 8);
+    std::fseek(out, 8, SEEK_SET);
+    std::fwrite(header + 8, 1, 8, out);
+    std::fclose(out);
+    std::cout << "Wrote " << count << " records to " << output << "\n";
+    return true;
 }
 
 
+bool process_file(BuddySimulator& sim, const std::string& filename) {
+    TraceReader reader(filename);
+    if (!reader.ok()) {
+        std::cerr << "Error: Could not open " << filename << "\n";
+        return false;
+    }
 
 
-void deallocate(int process_id) {
-    auto it = active_allocations.find(process_id);
-    if (it != active_allocations.end()) {
-        Block block = {it->second.size, 0};  
-        int order = find_order(block.size);
-        free_list[order].push_back(block);
-        std::cout << "Deallocated Process " << process_id << "\n";
-        active_allocations.erase(it);
+    Request batch[TRACE_BATCH];
+    while (size_t n = reader.next_batch(batch, TRACE_BATCH)) {
+        for (size_t i = 0; i < n; ++i) {
+            sim.tick(batch[i].request_time);
+            sim.allocate(batch[i].process_id, batch[i].units, batch[i].request_time, batch[i].duration);
+        }
     }
+
+
+    if (sim.verbose) std::cout << "All requests processed.\n";
+    return true;
 }
 
 
 
 
-void tick(int current_time) {
-    for (auto it = active_allocations.begin(); it != active_allocations.end();) {
-        if (it->second.end_time == current_time) {
-            deallocate(it->second.process_id);
-            it = active_allocations.erase(it); 
+// ---- Benchmark: buddy arena vs glibc malloc on the same request trace ----
+
+const size_t BENCH_UNIT_BYTES = 64;
+
+
+bool load_trace(const std::string& filename, std::vector<Request>& trace) {
+    TraceReader reader(filename);
+    if (!reader.ok()) {
+        std::cerr << "Error: Could not open " << filename << "\n";
+        return false;
+    }
+    Request batch[TRACE_BATCH];
+    while (size_t n = reader.next_batch(batch, TRACE_BATCH)) {
+        trace.insert(trace.end(), batch, batch + n);
+    }
+    return true;
+}
+
+
+std::vector<Request> synthetic_trace(size_t count, unsigned seed) {
+    std::mt19937 rng(seed);
+    std::geometric_distribution<int> small(0.08);
+    std::uniform_int_distribution<int> large(64, 4096);
+    std::uniform_int_distribution<int> life(1, 2000);
+    std::vector<Request> trace(count);
+    for (size_t i = 0; i < count; ++i) {
+        int units = (rng() % 16 == 0) ? large(rng) : 1 + small(rng);
+        trace[i] = {(int)i, units, (int)i, life(rng)};
+    }
+    return trace;
+}
+
+
+// A replay step: op >= 0 allocates trace[op], op < 0 frees trace[~op]
+struct ReplayPlan {
+    std::vector<long> ops;
+    size_t peak_op = 0;
+    size_t peak_bytes = 0;
+};
+
+
+ReplayPlan plan_replay(const std::vector<Request>& trace) {
+    ReplayPlan plan;
+    using End = std::pair<long, long>;
+    std::priority_queue<End, std::vector<End>, std::greater<End>> ends;
+    size_t live = 0;
+    for (size_t i = 0; i < trace.size(); ++i) {
+        while (!ends.empty() && ends.top().first <= trace[i].request_time) {
+            live -= trace[ends.top().second].units * BENCH_UNIT_BYTES;
+            plan.ops.push_back(~ends.top().second);
+            ends.pop();
+        }
+        plan.ops.push_back(i);
+        ends.push({(long)trace[i].request_time + trace[i].duration, (long)i});
+        live += trace[i].units * BENCH_UNIT_BYTES;
+        if (live > plan.peak_bytes) {
+            plan.peak_bytes = live;
+            plan.peak_op = plan.ops.size();
+        }
+    }
+    while (!ends.empty()) {
+        plan.ops.push_back(~ends.top().second);
+        ends.pop();
+    }
+    return plan;
+}
+
+
+long resident_kb() {
+    std::ifstream statm("/proc/self/statm");
+    long size = 0, resident = 0;
+    statm >> size >> resident;
+    return resident * (sysconf(_SC_PAGESIZE) / 1024);
+}
+
+
+struct ReplayResult {
+    double seconds;
+    long rss_kb;
+    size_t failures;
+};
+
+
+// Replays the plan against alloc/release; with touch set every page of every
+// block is written so the RSS sampled at peak reflects the real footprint.
+template <typename Alloc, typename Release>
+ReplayResult replay(const std::vector<Request>& trace, const ReplayPlan& plan, bool touch,
+                    Alloc alloc, Release release) {
+    std::vector<void*> ptrs(trace.size(), nullptr);
+    ReplayResult result = {0, 0, 0};
+    long rss_before = resident_kb();
+    auto begin = std::chrono::steady_clock::now();
+
+    for (size_t k = 0; k < plan.ops.size(); ++k) {
+        long op = plan.ops[k];
+        if (op >= 0) {
+            size_t bytes = trace[op].units * BENCH_UNIT_BYTES;
+            void* p = alloc(bytes);
+            if (!p) {
+                ++result.failures;
+            } else if (touch) {
+                for (size_t off = 0; off < bytes; off += 4096) static_cast<char*>(p)[off] = 1;
+            }
+            ptrs[op] = p;
         } else {
-            ++it;
+            op = ~op;
+            if (ptrs[op]) release(ptrs[op], trace[op].units * BENCH_UNIT_BYTES);
+            ptrs[op] = nullptr;
         }
+        if (touch && k + 1 == plan.peak_op) result.rss_kb = resident_kb() - rss_before;
     }
+
+    result.seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - begin).count();
+    return result;
 }
 
 
-void process_file(const std::string& filename) {
-    std::ifstream file(filename);
-    if (!file) {
-        std::cerr << "Error: Could not open " << filename << "\n";
-        return;
+void run_benchmark(const std::vector<Request>& trace) {
+    ReplayPlan plan = plan_replay(trace);
+    long arena_units = 1L << find_order(2 * plan.peak_bytes / BENCH_UNIT_BYTES);
+    int max_order = find_order(arena_units);
+
+    std::cout << "Requests: " << trace.size() << ", peak live bytes: " << plan.peak_bytes
+              << ", arena: " << arena_units * BENCH_UNIT_BYTES << " bytes\n";
+
+    auto run_buddy = [&](bool touch) {
+        BuddyAllocator arena(arena_units, BENCH_UNIT_BYTES, max_order);
+        return replay(trace, plan, touch,
+            [&](size_t bytes) -> void* {
+                try { return arena.allocate(bytes); } catch (const std::bad_alloc&) { return nullptr; }
+            },
+            [&](void* p, size_t bytes) { arena.deallocate(p, bytes); });
+    };
+    auto run_malloc = [&](bool touch) {
+        return replay(trace, plan, touch,
+            [](size_t bytes) { return std::malloc(bytes); },
+            [](void* p, size_t) { std::free(p); });
+    };
+
+    // RSS passes run first so malloc measures a fresh heap, not pages left
+    // resident by an earlier pass
+    ReplayResult results[2][2];
+    results[1][1] = run_malloc(true);
+    results[0][1] = run_buddy(true);
+    results[0][0] = run_buddy(false);
+    results[1][0] = run_malloc(false);
+    const char* names[2] = {"buddy ", "malloc"};
+    for (int i = 0; i < 2; ++i) {
+        std::cout << names[i] << ": " << plan.ops.size() / results[i][0].seconds / 1e6 << " Mops/s, "
+                  << "peak RSS " << results[i][1].rss_kb << " KB, "
+                  << results[i][0].failures << " failed allocations\n";
     }
+}
 
 
-    int process_id, units, request_time, duration;
-    while (file >> process_id >> units >> request_time >> duration) {
-        if (process_id < 0) break;  
-        tick(request_time);  
-        allocate(process_id, units, request_time, duration);
+// ---- Multi-threaded benchmark: magazines vs one global lock vs malloc ----
+
+const size_t MT_OPS_PER_THREAD = 2000000;
+const int MT_LIVE_WINDOW = 256;
+
+
+// Each thread keeps a ring of live blocks and replaces the oldest one per
+// step; one request in 16 is above the magazine orders.
+template <typename Alloc, typename Release>
+void mt_worker(unsigned seed, Alloc alloc, Release release) {
+    std::mt19937 rng(seed);
+    void* live[MT_LIVE_WINDOW] = {};
+    size_t sizes[MT_LIVE_WINDOW] = {};
+    for (size_t i = 0; i < MT_OPS_PER_THREAD; ++i) {
+        int slot = i % MT_LIVE_WINDOW;
+        if (live[slot]) release(live[slot], sizes[slot]);
+        unsigned r = rng();
+        sizes[slot] = BENCH_UNIT_BYTES << ((r & 15) == 0 ? 4 + (r >> 4) % 3 : (r >> 4) % 4);
+        live[slot] = alloc(sizes[slot]);
     }
+    for (int slot = 0; slot < MT_LIVE_WINDOW; ++slot) {
+        if (live[slot]) release(live[slot], sizes[slot]);
+    }
+}
 
 
-    std::cout << "All requests processed.\n";
+template <typename Body>
+double mt_ops_per_sec(int threads, Body body) {
+    std::vector<std::thread> pool;
+    auto begin = std::chrono::steady_clock::now();
+    for (int t = 0; t < threads; ++t) {
+        pool.emplace_back(body, t + 1);
+    }
+    for (auto& th : pool) th.join();
+    double seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - begin).count();
+    return 2.0 * MT_OPS_PER_THREAD * threads / seconds;
 }
 
 
-int main() {
-    int total_memory = 1024; 
-    init_memory(total_memory);
+void run_mt_benchmark(int max_threads) {
+    const long arena_units = 1L << 22;
+    std::cout << "threads   magazines(Mops/s)   global-lock(Mops/s)   malloc(Mops/s)\n";
+    std::vector<int> counts;
+    for (int threads = 1; threads < max_threads; threads *= 2) counts.push_back(threads);
+    counts.push_back(max_threads);
+
+    for (int threads : counts) {
+        ConcurrentBuddy cached(arena_units, BENCH_UNIT_BYTES, 22);
+        double with_magazines = mt_ops_per_sec(threads, [&](unsigned seed) {
+            ConcurrentBuddy::ThreadCache cache(cached);
+            mt_worker(seed,
+                [&](size_t bytes) { return cache.allocate(bytes); },
+                [&](void* p, size_t bytes) { cache.deallocate(p, bytes); });
+        });
+
+        ConcurrentBuddy locked(arena_units, BENCH_UNIT_BYTES, 22);
+        char* base = locked.central().base();
+        double global_lock = mt_ops_per_sec(threads, [&](unsigned seed) {
+            mt_worker(seed,
+                [&](size_t bytes) -> void* {
+                    long start = locked.allocate_central(locked.central().order_for(bytes));
+                    return start < 0 ? nullptr : base + start * BENCH_UNIT_BYTES;
+                },
+                [&](void* p, size_t bytes) {
+                    locked.free_central((static_cast<char*>(p) - base) / BENCH_UNIT_BYTES,
+                                        locked.central().order_for(bytes));
+                });
+        });
+
+        double with_malloc = mt_ops_per_sec(threads, [&](unsigned seed) {
+            mt_worker(seed,
+                [](size_t bytes) { return std::malloc(bytes); },
+                [](void* p, size_t) { std::free(p); });
+        });
+
+        std::cout << std::setw(7) << threads << std::setw(20) << with_magazines / 1e6
+                  << std::setw(22) << global_lock / 1e6 << std::setw(17) << with_malloc / 1e6 << "\n";
+    }
+}
+
+
+
+int main(int argc, char** argv) {
+    if (argc > 1 && std::string(argv[1]) == "--bench") {
+        std::vector<Request> trace;
+        if (argc <= 2) {
+            trace = synthetic_trace(2000000, 1);
+        } else if (!load_trace(argv[2], trace)) {
+            return 1;
+        } else if (trace.empty()) {
+            std::cerr << "Error: No requests in " << argv[2] << "\n";
+            return 1;
+        }
+        run_benchmark(trace);
+        return 0;
+    }
+    if (argc > 1 && std::string(argv[1]) == "--mt-bench") {
+        int max_threads = argc > 2 ? std::stoi(argv[2]) : std::max(1u, std::thread::hardware_concurrency());
+        run_mt_benchmark(max_threads);
+        return 0;
+    }
+    if (argc > 3 && std::string(argv[1]) == "--convert") {
+        return convert_trace(argv[2], argv[3]) ? 0 : 1;
+    }
+    if (argc > 2 && std::string(argv[1]) == "--replay") {
+        long total_memory = argc > 3 ? std::stol(argv[3]) : 1L << 20;
+        BuddySimulator sim(total_memory, find_order(total_memory));
+        sim.verbose = false;
+        auto begin = std::chrono::steady_clock::now();
+        if (!process_file(sim, argv[2])) return 1;
+        double seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - begin).count();
+        std::cout << "Replayed " << sim.requests << " requests (" << sim.failures << " failed) in "
+                  << seconds << " s, " << sim.requests / seconds / 1e6 << " M requests/s\n";
+        return 0;
+    }
+
+    int total_memory = 1024;
+    BuddySimulator sim(total_memory);
 
 
-    process_file("buddy.dat");
+    if (!process_file(sim, "buddy.dat")) return 1;
 
 
     return 0;
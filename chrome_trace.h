@@ -0,0 +1,137 @@
+#ifndef CHROME_TRACE_H
+#define CHROME_TRACE_H
+
+#include <cstdio>
+#include <cstring>
+#include <cmath>
+#include <charconv>
+
+// Streaming writer for the Chrome trace-event JSON format, which Perfetto
+// and chrome://tracing open directly. Events are formatted into a fixed
+// buffer that is written out with one fwrite whenever it fills, so an event
+// costs no allocation and no system call. Timestamps and durations are in
+// microseconds. Tracks are addressed as (pid, tid) pairs; metadata events
+// give them names.
+class ChromeTraceWriter {
+public:
+    explicit ChromeTraceWriter(const char *path) : file(std::fopen(path, "wb")) {
+        append("{\"traceEvents\":[\n");
+    }
+
+    ~ChromeTraceWriter() { close(); }
+
+    ChromeTraceWriter(const ChromeTraceWriter &) = delete;
+    ChromeTraceWriter &operator=(const ChromeTraceWriter &) = delete;
+
+    bool ok() const { return file != nullptr; }
+
+    void process_name(int pid, const char *name) {
+        metadata("process_name", pid, 0, name, -1);
+    }
+
+    // Names a track prefix followed by id, e.g. ("Process ", 12); a negative
+    // id leaves the prefix on its own. The same holds for slice names.
+    void thread_name(int pid, int tid, const char *prefix, long id = -1) {
+        metadata("thread_name", pid, tid, prefix, id);
+    }
+
+    // A complete ("X") event covering [start, start + duration)
+    void slice(int pid, int tid, const char *prefix, long id, double start, double duration) {
+        begin_event();
+        append("{\"ph\":\"X\",\"pid\":");
+        append_int(pid);
+        append(",\"tid\":");
+        append_int(tid);
+        append(",\"ts\":");
+        append_time(start);
+        append(",\"dur\":");
+        append_time(duration);
+        append(",\"name\":\"");
+        append_escaped(prefix);
+        if (id >= 0) append_int(id);
+        append("\"}");
+    }
+
+    void close() {
+        if (!file) return;
+        append("\n]}\n");
+        flush();
+        std::fclose(file);
+        file = nullptr;
+    }
+
+private:
+    void metadata(const char *kind, int pid, int tid, const char *prefix, long id) {
+        begin_event();
+        append("{\"ph\":\"M\",\"pid\":");
+        append_int(pid);
+        append(",\"tid\":");
+        append_int(tid);
+        append(",\"name\":\"");
+        append(kind, std::strlen(kind));
+        append("\",\"args\":{\"name\":\"");
+        append_escaped(prefix);
+        if (id >= 0) append_int(id);
+        append("\"}}");
+    }
+
+    void begin_event() {
+        if (events++ > 0) append(",\n");
+    }
+
+    template <size_t N>
+    void append(const char (&text)[N]) { append(text, N - 1); }
+
+    void append(const char *text, size_t length) {
+        if (used + length > sizeof(buffer)) flush();
+        if (length > sizeof(buffer)) {
+            if (file) std::fwrite(text, 1, length, file);
+            return;
+        }
+        std::memcpy(buffer + used, text, length);
+        used += length;
+    }
+
+    void append_escaped(const char *text) {
+        size_t length = std::strlen(text);
+        if (!std::memchr(text, '"', length) && !std::memchr(text, '\\', length)) {
+            append(text, length);
+            return;
+        }
+        for (; *text; ++text) {
+            if (*text == '"' || *text == '\\') append("\\", 1);
+            append(text, 1);
+        }
+    }
+
+    void append_int(long long value) {
+        if (used + 24 > sizeof(buffer)) flush();
+        used = std::to_chars(buffer + used, buffer + sizeof(buffer), value).ptr - buffer;
+    }
+
+    // Fixed point with up to three decimals, i.e. nanosecond resolution
+    void append_time(double us) {
+        long long ns = std::llround(us * 1000);
+        if (ns < 0) {
+            append("-", 1);
+            ns = -ns;
+        }
+        append_int(ns / 1000);
+        int frac = ns % 1000;
+        if (frac == 0) return;
+        char digits[4] = {'.', char('0' + frac / 100), char('0' + frac / 10 % 10), char('0' + frac % 10)};
+        append(digits, 4);
+    }
+
+    void flush() {
+        if (file && used > 0) std::fwrite(buffer, 1, used, file);
+        used = 0;
+    }
+
+    std::FILE *file;
+    char buffer[1 << 16];
+    size_t used = 0;
+    long events = 0;
+};
+
+#endif
@@ -1,16 +1,40 @@
-
 #include <iostream>
 #include <fstream>
 #include <vector>
 #include <cmath>
 #include <algorithm>
 #include <iomanip>
+#include <string>
+#include <sstream>
+#include <deque>
+#include <set>
+#include <utility>
+#include <tuple>
+#include <climits>
+#include <cstdint>
 
 using namespace std;
 
 
-void readDiskParameters(const string &filename, int &numCylinders, int &numSectors, int &bytesPerSector,
-                    	int &rpm, double &avgSeekTime, int &initialHeadPosition, vector<int> &requests) {
+// One request per line as "[time] address R|W" or "time address bytes R|W"
+// with the arrival time in seconds (0 when left out) and the transfer
+// length in bytes (one sector when left out). A line without R or W is a
+// plain list of addresses, all one-sector reads arriving at time 0. An
+// address is a cylinder, or with --lba a logical block address that is
+// mapped to a cylinder and sector; sector is -1 for requests given by
+// cylinder.
+struct DiskRequest {
+	double arrival;
+	int cylinder;
+	int sector;
+	long long bytes;
+	bool write;
+	int index;
+};
+
+
+void readDiskParameters(const string &filename, bool lba, int &numCylinders, int &numSectors, int &bytesPerSector,
+                    	int &rpm, double &avgSeekTime, int &initialHeadPosition, vector<DiskRequest> &requests) {
 	ifstream infile(filename);
 	if (!infile) {
     	cerr << "Error opening file." << endl;
@@ -24,180 +48,622 @@ void readDiskParameters(const string &filename, int &numCylinders, int &numSecto
 	infile >> avgSeekTime;
 	infile >> initialHeadPosition;
 
-	int request;
-	while (infile >> request) {
+	// Blocks are numbered along a track, then track by track inward, one
+	// track per cylinder
+	auto addRequest = [&](double arrival, const string &address, long long bytes, bool write) {
+    	if (bytes <= 0) {
+        	cerr << "Request lengths must be positive." << endl;
+        	exit(1);
+    	}
+    	long long value = stoll(address);
+    	DiskRequest request = {arrival, (int)value, -1, bytes, write, (int)requests.size()};
+    	if (lba) {
+        	if (value < 0 || value >= (long long)numCylinders * numSectors) {
+            	cerr << "LBA " << value << " is beyond the last sector." << endl;
+            	exit(1);
+        	}
+        	request.cylinder = value / numSectors;
+        	request.sector = value % numSectors;
+    	}
     	requests.push_back(request);
+	};
+
+	string line;
+	while (getline(infile, line)) {
+    	stringstream ss(line);
+    	vector<string> tokens;
+    	string token;
+    	while (ss >> token) {
+        	tokens.push_back(token);
+    	}
+    	if (tokens.empty()) continue;
+
+    	char type = toupper(tokens.back()[0]);
+    	if (type == 'R' || type == 'W') {
+        	double arrival = tokens.size() > 2 ? stod(tokens[0]) : 0.0;
+        	long long bytes = tokens.size() > 3 ? stoll(tokens[2]) : bytesPerSector;
+        	addRequest(arrival, tokens[tokens.size() > 2 ? 1 : 0], bytes, type == 'W');
+    	} else {
+        	for (const string &address : tokens) {
+            	addRequest(0.0, address, bytesPerSector, false);
+        	}
+    	}
 	}
 
 	infile.close();
 }
 
 
-double calculateAverageRotationalDelay(int numSectors, int rpm) {
-	double rotationTimePerRevolution = 60.0 / rpm;
-	double rotationalDelay = rotationTimePerRevolution / numSectors;
-	return rotationalDelay;
-}
-
-
 double calculateSeekTime(int start, int end, double avgSeekTime) {
 	return avgSeekTime * abs(start - end);
 }
 
 
-void fcfsScheduling(const vector<int> &requests, int initialHeadPosition, double avgSeekTime,
-                	double rotationalDelay, int numSectors) {
-	double totalSeekTime = 0.0;
-	double totalRotationalDelay = 0.0;
-	int currentPosition = initialHeadPosition;
-   
-	for (int request : requests) {
-    	totalSeekTime += calculateSeekTime(currentPosition, request, avgSeekTime);
-    	totalRotationalDelay += rotationalDelay * (abs(currentPosition - request) % numSectors);
-    	currentPosition = request;
-	}
-   
-	double averageRotationalDelay = totalRotationalDelay / requests.size();
+// A single-surface disk with one track per cylinder and numSectors sectors
+// of bytesPerSector bytes on every track. The platter turns continuously
+// with the start of sector 0 under the head at time 0, so the angular
+// position is known at any time. Serving a request takes its seek, the
+// rotational latency until its sector comes round, and the transfer while
+// its sectors pass under the head. A transfer is whole sectors, so its
+// length is rounded up to a multiple of bytesPerSector; it is charged as
+// if it ran on along the track, without a seek into the next cylinder.
+// Requests given by cylinder have no known sector and wait the average
+// latency of half a revolution.
+struct DiskModel {
+	int numCylinders;
+	int numSectors;
+	int bytesPerSector;
+	int rpm;
+	double avgSeekTime;
+	int initialHeadPosition;
 
-	cout << "FCFS Scheduling:" << endl;
-	cout << "Average Rotational Delay: " << averageRotationalDelay << " seconds" << endl;
-	cout << "Total Seek Time: " << totalSeekTime << " seconds" << endl;
+	double revolutionTime() const { return 60.0 / rpm; }
+
+	// Bytes per second passing under the head
+	double transferRate() const { return (double)bytesPerSector * numSectors / revolutionTime(); }
+
+	double transferTime(long long bytes) const {
+    	long long sectors = (bytes + bytesPerSector - 1) / bytesPerSector;
+    	return sectors * bytesPerSector / transferRate();
+	}
+
+	// Position under the head at time, in sectors from the start of sector 0
+	double angularPosition(double time) const {
+    	return fmod(time / revolutionTime(), 1.0) * numSectors;
+	}
+
+	double rotationalLatency(double time, int sector) const {
+    	if (sector < 0) return revolutionTime() / 2;
+    	double sectors = sector - angularPosition(time);
+    	// Rounding can put the head a hair past a sector it reaches exactly
+    	if (sectors < -1e-6) sectors += numSectors;
+    	return max(0.0, sectors) * revolutionTime() / numSectors;
+	}
+};
+
+
+struct Access {
+	double seek, rotation, transfer;
+	double total() const { return seek + rotation + transfer; }
+};
+
+
+Access accessTime(const DiskModel &disk, int head, double now, const DiskRequest &request) {
+	double seek = calculateSeekTime(head, request.cylinder, disk.avgSeekTime);
+	double rotation = disk.rotationalLatency(now + seek, request.sector);
+	return {seek, rotation, disk.transferTime(request.bytes)};
 }
 
 
-void sstfScheduling(const vector<int> &requests, int initialHeadPosition, double avgSeekTime,
-                	double rotationalDelay, int numSectors) {
-	vector<int> sortedRequests = requests;
-	sort(sortedRequests.begin(), sortedRequests.end());
+// The request indices sorted by cylinder and sector once, shared by every
+// policy, with their cylinders alongside. split is the position of the
+// first request at or above the initial head position, so requests below
+// the head are order[0, split) and the rest follow.
+struct SortedRequests {
+	vector<int> order;
+	vector<int> cylinders;
+	size_t split;
+};
 
-	double totalSeekTime = 0.0;
-	double totalRotationalDelay = 0.0;
-	int currentPosition = initialHeadPosition;
-	vector<int> servedRequests;
 
-	while (!sortedRequests.empty()) {
-    	auto closest = min_element(sortedRequests.begin(), sortedRequests.end(),
-                               	[currentPosition](int a, int b) {
-                                   	return abs(a - currentPosition) < abs(b - currentPosition);
-                               	});
+SortedRequests sortRequests(const vector<DiskRequest> &requests, int initialHeadPosition) {
+	SortedRequests sorted;
+	for (const DiskRequest &request : requests) {
+    	sorted.order.push_back(request.index);
+	}
+	sort(sorted.order.begin(), sorted.order.end(), [&](int a, int b) {
+    	return make_pair(requests[a].cylinder, requests[a].sector) < make_pair(requests[b].cylinder, requests[b].sector);
+	});
+	for (int index : sorted.order) {
+    	sorted.cylinders.push_back(requests[index].cylinder);
+	}
+	sorted.split = lower_bound(sorted.cylinders.begin(), sorted.cylinders.end(), initialHeadPosition)
+            	   - sorted.cylinders.begin();
+	return sorted;
+}
 
-    	int request = *closest;
-    	servedRequests.push_back(request);
-    	sortedRequests.erase(closest);
 
-    	totalSeekTime += calculateSeekTime(currentPosition, request, avgSeekTime);
-    	totalRotationalDelay += rotationalDelay * (abs(currentPosition - request) % numSectors);
-    	currentPosition = request;
+// Services the requests at the indices in path in order and prints the
+// totals. A path entry of -1 is the C-SCAN return to cylinder 0, which
+// only seeks.
+void printSchedule(const string &name, const vector<int> &path, const vector<DiskRequest> &requests,
+            	   const DiskModel &disk) {
+	double totalSeekTime = 0.0;
+	double totalRotationalDelay = 0.0;
+	double now = 0.0;
+	int currentPosition = disk.initialHeadPosition;
+
+	for (int index : path) {
+    	if (index < 0) {
+        	double seekTime = calculateSeekTime(currentPosition, 0, disk.avgSeekTime);
+        	totalSeekTime += seekTime;
+        	now += seekTime;
+        	currentPosition = 0;
+        	continue;
+    	}
+    	Access access = accessTime(disk, currentPosition, now, requests[index]);
+    	totalSeekTime += access.seek;
+    	totalRotationalDelay += access.rotation;
+    	now += access.total();
+    	currentPosition = requests[index].cylinder;
 	}
 
 	double averageRotationalDelay = totalRotationalDelay / requests.size();
 
-	cout << "SSTF Scheduling:" << endl;
+	cout << name << " Scheduling:" << endl;
 	cout << "Average Rotational Delay: " << averageRotationalDelay << " seconds" << endl;
 	cout << "Total Seek Time: " << totalSeekTime << " seconds" << endl;
+	cout << "Total Service Time: " << now << " seconds" << endl;
 }
 
 
-void lookScheduling(const vector<int> &requests, int initialHeadPosition, double avgSeekTime,
-                	double rotationalDelay, int numSectors) {
-	vector<int> sortedRequests = requests;
-	sort(sortedRequests.begin(), sortedRequests.end());
+void fcfsScheduling(const vector<DiskRequest> &requests, const DiskModel &disk) {
+	vector<int> path;
+	for (const DiskRequest &request : requests) {
+    	path.push_back(request.index);
+	}
+	printSchedule("FCFS", path, requests, disk);
+}
 
-	vector<int> left, right;
-	for (int request : sortedRequests) {
-    	if (request < initialHeadPosition) {
-        	left.push_back(request);
-    	} else {
-        	right.push_back(request);
-    	}
+
+// Once the head has served a request, every request between it and the
+// head's starting point has been served too, so the closest remaining
+// request is always one of the two nearest unserved neighbours in sorted
+// order. Expanding two pointers outward from the head makes SSTF linear
+// after the sort. Ties go to the lower cylinder.
+void sstfScheduling(const vector<DiskRequest> &requests, const SortedRequests &sorted, const DiskModel &disk) {
+	const vector<int> &cylinders = sorted.cylinders;
+	vector<int> path;
+	path.reserve(cylinders.size());
+	int currentPosition = disk.initialHeadPosition;
+	size_t below = sorted.split, above = sorted.split;
+
+	while (below > 0 || above < cylinders.size()) {
+    	bool takeBelow = above == cylinders.size() ||
+                    	 (below > 0 && currentPosition - cylinders[below - 1] <= cylinders[above] - currentPosition);
+    	size_t next = takeBelow ? --below : above++;
+    	currentPosition = cylinders[next];
+    	path.push_back(sorted.order[next]);
 	}
 
-	double totalSeekTime = 0.0;
-	double totalRotationalDelay = 0.0;
-	int currentPosition = initialHeadPosition;
+	printSchedule("SSTF", path, requests, disk);
+}
+
 
+// Sweeps up to the highest request, then reverses and serves the rest on
+// the way down
+void lookScheduling(const vector<DiskRequest> &requests, const SortedRequests &sorted, const DiskModel &disk) {
+	const vector<int> &order = sorted.order;
+	vector<int> path(order.begin() + sorted.split, order.end());
+	path.insert(path.end(), order.rbegin() + (order.size() - sorted.split), order.rend());
 
-	for (int request : right) {
-    	totalSeekTime += calculateSeekTime(currentPosition, request, avgSeekTime);
-    	totalRotationalDelay += rotationalDelay * (abs(currentPosition - request) % numSectors);
-    	currentPosition = request;
+	printSchedule("LOOK", path, requests, disk);
+}
+
+
+// Sweeps up to the highest request, returns to cylinder 0 and sweeps up
+// again through the requests below the starting position
+void cscanScheduling(const vector<DiskRequest> &requests, const SortedRequests &sorted, const DiskModel &disk) {
+	const vector<int> &order = sorted.order;
+	vector<int> path(order.begin() + sorted.split, order.end());
+	if (!path.empty()) {
+    	path.push_back(-1);
 	}
+	path.insert(path.end(), order.begin(), order.begin() + sorted.split);
 
+	printSchedule("C-SCAN", path, requests, disk);
+}
 
-	for (int request : left) {
-    	totalSeekTime += calculateSeekTime(currentPosition, request, avgSeekTime);
-    	totalRotationalDelay += rotationalDelay * (abs(currentPosition - request) % numSectors);
-    	currentPosition = request;
+// Online scheduling: requests enter the queue at their arrival times and
+// the head services them one at a time, each taking its access time under
+// the DiskModel. Every queue below offers add(request), empty() and
+// next(head, now), which removes and returns the index of the request to
+// service next.
+using CylinderSet = multiset<pair<int, int>>;
+
+
+class FcfsQueue {
+public:
+	static const char *name() { return "FCFS"; }
+	void add(const DiskRequest &request) { fifo.push_back(request.index); }
+	bool empty() const { return fifo.empty(); }
+	int next(int, double) {
+    	int index = fifo.front();
+    	fifo.pop_front();
+    	return index;
 	}
 
-	double averageRotationalDelay = totalRotationalDelay / requests.size();
+private:
+	deque<int> fifo;
+};
+
+
+// Pending requests ordered by cylinder; the closest one is next to the
+// head's position in the set. Ties go to the lower cylinder.
+class SstfQueue {
+public:
+	static const char *name() { return "SSTF"; }
+	void add(const DiskRequest &request) { pending.insert({request.cylinder, request.index}); }
+	bool empty() const { return pending.empty(); }
+	int next(int head, double) {
+    	auto above = pending.lower_bound({head, -1});
+    	auto chosen = above;
+    	if (above == pending.end() || (above != pending.begin() && head - prev(above)->first <= above->first - head)) {
+        	chosen = prev(above);
+    	}
+    	int index = chosen->second;
+    	pending.erase(chosen);
+    	return index;
+	}
 
-	cout << "LOOK Scheduling:" << endl;
-	cout << "Average Rotational Delay: " << averageRotationalDelay << " seconds" << endl;
-	cout << "Total Seek Time: " << totalSeekTime << " seconds" << endl;
-}
+private:
+	CylinderSet pending;
+};
+
+
+// Serves a frozen batch with an elevator sweep that reverses at the last
+// request in its direction. Arrivals wait in FIFO order outside the batch;
+// a new batch takes the first batchSize of them, or all of them for FSCAN,
+// once the current batch is done. Freezing the batch stops a stream of
+// requests near the head from starving the rest.
+class BatchedScanQueue {
+public:
+	explicit BatchedScanQueue(size_t batchSize) : batchSize(batchSize) {}
+
+	const char *name() const { return batchSize == SIZE_MAX ? "FSCAN" : "N-step SCAN"; }
+	void add(const DiskRequest &request) { waiting.push_back({request.cylinder, request.index}); }
+	bool empty() const { return batch.empty() && waiting.empty(); }
+
+	int next(int head, double) {
+    	if (batch.empty()) {
+        	size_t count = min(batchSize, waiting.size());
+        	batch.insert(waiting.begin(), waiting.begin() + count);
+        	waiting.erase(waiting.begin(), waiting.begin() + count);
+    	}
+    	auto chosen = batch.lower_bound({head, -1});
+    	if (up && chosen == batch.end()) {
+        	up = false;
+    	} else if (!up && chosen == batch.begin() && chosen->first > head) {
+        	up = true;
+    	}
+    	if (!up) {
+        	chosen = prev(batch.upper_bound({head, INT_MAX}));
+    	}
+    	int index = chosen->second;
+    	batch.erase(chosen);
+    	return index;
+	}
 
+private:
+	size_t batchSize;
+	deque<pair<int, int>> waiting;
+	CylinderSet batch;
+	bool up = true;
+};
+
+
+// Deadline scheduling in the style of Linux mq-deadline. Reads and writes
+// each have a cylinder-sorted set and a FIFO of expiry times (arrival plus
+// readExpire or writeExpire). Requests are dispatched in batches of up to
+// fifoBatch in ascending cylinder order from the head. A new batch prefers
+// reads, unless writes have been passed over writesStarved times, and
+// starts at the oldest request of its direction if that one has expired.
+struct DeadlineConfig {
+	double readExpire = 0.5;
+	double writeExpire = 5.0;
+	int fifoBatch = 16;
+	int writesStarved = 2;
+};
+
+
+class DeadlineQueue {
+public:
+	explicit DeadlineQueue(const DeadlineConfig &config) : config(config) {}
+
+	static const char *name() { return "Deadline"; }
+
+	void add(const DiskRequest &request) {
+    	int dir = request.write ? 1 : 0;
+    	double expire = request.write ? config.writeExpire : config.readExpire;
+    	sorted[dir].insert({request.cylinder, request.index});
+    	fifo[dir].push_back({request.arrival + expire, {request.cylinder, request.index}});
+	}
 
-void cscanScheduling(const vector<int> &requests, int initialHeadPosition, double avgSeekTime,
-                 	double rotationalDelay, int numCylinders) {
-	vector<int> sortedRequests = requests;
-	sort(sortedRequests.begin(), sortedRequests.end());
+	bool empty() const { return sorted[0].empty() && sorted[1].empty(); }
 
-	vector<int> left, right;
-	for (int request : sortedRequests) {
-    	if (request < initialHeadPosition) {
-        	left.push_back(request);
+	int next(int head, double now) {
+    	CylinderSet::iterator chosen;
+    	if (batching < config.fifoBatch && (chosen = sorted[dir].lower_bound({head, -1})) != sorted[dir].end()) {
+        	batching++;
     	} else {
-        	right.push_back(request);
+        	bool reads = !sorted[0].empty(), writes = !sorted[1].empty();
+        	if (reads && (!writes || starved < config.writesStarved)) {
+            	if (writes) starved++;
+            	dir = 0;
+        	} else {
+            	starved = 0;
+            	dir = 1;
+        	}
+        	dropServed(dir);
+        	chosen = sorted[dir].lower_bound({head, -1});
+        	if (fifo[dir].front().first <= now || chosen == sorted[dir].end()) {
+            	chosen = sorted[dir].find(fifo[dir].front().second);
+        	}
+        	batching = 1;
     	}
+    	int index = chosen->second;
+    	sorted[dir].erase(chosen);
+    	return index;
 	}
 
-	double totalSeekTime = 0.0;
-	double totalRotationalDelay = 0.0;
-	int currentPosition = initialHeadPosition;
+private:
+	// FIFO entries are removed lazily once their request has been served
+	void dropServed(int d) {
+    	while (!fifo[d].empty() && !sorted[d].count(fifo[d].front().second)) {
+        	fifo[d].pop_front();
+    	}
+	}
 
+	DeadlineConfig config;
+	CylinderSet sorted[2];
+	deque<pair<double, pair<int, int>>> fifo[2];
+	int dir = 0;
+	int batching = 0;
+	int starved = 0;
+};
+
+
+// Shortest Access Time First: serves the pending request with the least
+// seek plus rotational latency from the head's current cylinder and
+// angular position. Pending requests are ordered by cylinder and sector,
+// so within a cylinder the request reached first is the first sector at or
+// after the angular position once the seek is done, wrapping round to the
+// lowest. The search visits cylinders outward from the head and stops once
+// the seek alone reaches the best access time found, so a pick costs one
+// lookup per cylinder within a revolution's worth of seek. Ties go to the
+// nearer cylinder, then the lower one. While no pending request has a
+// known sector every access waits the same half revolution, and the pick
+// is the SSTF one.
+class SatfQueue {
+public:
+	SatfQueue(const DiskModel &disk, const vector<DiskRequest> &requests) : disk(&disk), requests(&requests) {}
+
+	static const char *name() { return "SATF"; }
+
+	void add(const DiskRequest &request) {
+    	pending.insert({request.cylinder, request.sector, request.index});
+    	if (request.sector >= 0) known++;
+	}
+
+	bool empty() const { return pending.empty(); }
 
-	for (int request : right) {
-    	totalSeekTime += calculateSeekTime(currentPosition, request, avgSeekTime);
-    	totalRotationalDelay += rotationalDelay * (abs(currentPosition - request) % numCylinders);
-    	currentPosition = request;
+	int next(int head, double now) {
+    	auto chosen = known > 0 ? fastest(head, now) : nearest(head);
+    	int index = get<2>(*chosen);
+    	if (get<1>(*chosen) >= 0) known--;
+    	pending.erase(chosen);
+    	return index;
 	}
 
+private:
+	using Pending = set<tuple<int, int, int>>;
+
+	Pending::iterator firstOf(int cylinder) const { return pending.lower_bound({cylinder, INT_MIN, INT_MIN}); }
 
-	if (!right.empty()) {
-    	totalSeekTime += calculateSeekTime(currentPosition, 0, avgSeekTime);
-    	totalRotationalDelay += rotationalDelay * (abs(currentPosition - 0) % numCylinders);
-    	currentPosition = 0;
+	Pending::iterator nearest(int head) const {
+    	auto above = firstOf(head);
+    	if (above != pending.end() && (above == pending.begin() || get<0>(*above) - head < head - get<0>(*prev(above)))) {
+        	return above;
+    	}
+    	return firstOf(get<0>(*prev(above)));
 	}
 
+	Pending::iterator fastest(int head, double now) const {
+    	auto above = firstOf(head), below = above;
+    	auto chosen = pending.end();
+    	double best = HUGE_VAL;
+
+    	while (above != pending.end() || below != pending.begin()) {
+        	bool up = below == pending.begin() ||
+                	  (above != pending.end() && get<0>(*above) - head < head - get<0>(*prev(below)));
+        	int cylinder = get<0>(*(up ? above : prev(below)));
+        	double seek = calculateSeekTime(head, cylinder, disk->avgSeekTime);
+        	if (seek >= best) break;
+
+        	auto first = up ? above : firstOf(cylinder);
+        	auto candidate = first;
+        	if (get<1>(*first) < 0) {
+            	consider(first, head, now, chosen, best);
+            	candidate = pending.lower_bound({cylinder, 0, INT_MIN});
+        	}
+        	if (candidate != pending.end() && get<0>(*candidate) == cylinder) {
+            	// The same rounding allowance as DiskModel::rotationalLatency
+            	int sector = (int)ceil(disk->angularPosition(now + seek) - 1e-6);
+            	auto reached = pending.lower_bound({cylinder, sector, INT_MIN});
+            	consider(reached != pending.end() && get<0>(*reached) == cylinder ? reached : candidate,
+                    	 head, now, chosen, best);
+        	}
+
+        	if (up) {
+            	above = firstOf(cylinder + 1);
+        	} else {
+            	below = first;
+        	}
+    	}
+    	return chosen;
+	}
 
-	for (int request : left) {
-    	totalSeekTime += calculateSeekTime(currentPosition, request, avgSeekTime);
-    	totalRotationalDelay += rotationalDelay * (abs(currentPosition - request) % numCylinders);
-    	currentPosition = request;
+	void consider(Pending::iterator candidate, int head, double now, Pending::iterator &chosen, double &best) const {
+    	Access access = accessTime(*disk, head, now, (*requests)[get<2>(*candidate)]);
+    	if (access.seek + access.rotation < best) {
+        	best = access.seek + access.rotation;
+        	chosen = candidate;
+    	}
 	}
 
-	double averageRotationalDelay = totalRotationalDelay / requests.size();
+	const DiskModel *disk;
+	const vector<DiskRequest> *requests;
+	Pending pending;
+	size_t known = 0;
+};
 
-	cout << "C-SCAN Scheduling:" << endl;
-	cout << "Average Rotational Delay: " << averageRotationalDelay << " seconds" << endl;
+
+// SATF decides by the time each request would be reached, so the static
+// schedule is built by running the queue with every request pending
+void satfScheduling(const vector<DiskRequest> &requests, const DiskModel &disk) {
+	SatfQueue queue(disk, requests);
+	for (const DiskRequest &request : requests) {
+    	queue.add(request);
+	}
+
+	vector<int> path;
+	double now = 0.0;
+	int currentPosition = disk.initialHeadPosition;
+	while (!queue.empty()) {
+    	int index = queue.next(currentPosition, now);
+    	now += accessTime(disk, currentPosition, now, requests[index]).total();
+    	currentPosition = requests[index].cylinder;
+    	path.push_back(index);
+	}
+
+	printSchedule("SATF", path, requests, disk);
+}
+
+
+// Nearest rank: the smallest sample with at least a share q of the
+// samples at or below it
+double percentile(vector<double> values, double q) {
+	if (values.empty()) return 0;
+	size_t rank = (size_t)ceil(q * values.size() - 1e-9);
+	size_t k = min(values.size() - 1, rank > 0 ? rank - 1 : 0);
+	nth_element(values.begin(), values.begin() + k, values.end());
+	return values[k];
+}
+
+
+// requests must be ordered by arrival time. Latency runs from arrival to
+// the end of the transfer.
+template <class Queue>
+void onlineScheduling(Queue queue, const vector<DiskRequest> &requests, const DiskModel &disk) {
+	double totalSeekTime = 0.0;
+	double totalRotationalDelay = 0.0;
+	double now = 0.0;
+	int currentPosition = disk.initialHeadPosition;
+	vector<double> latency, readLatency, writeLatency;
+	size_t arrived = 0;
+
+	while (arrived < requests.size() || !queue.empty()) {
+    	if (queue.empty()) now = max(now, requests[arrived].arrival);
+    	while (arrived < requests.size() && requests[arrived].arrival <= now) {
+        	queue.add(requests[arrived++]);
+    	}
+
+    	const DiskRequest &request = requests[queue.next(currentPosition, now)];
+    	Access access = accessTime(disk, currentPosition, now, request);
+    	totalSeekTime += access.seek;
+    	totalRotationalDelay += access.rotation;
+    	now += access.total();
+    	currentPosition = request.cylinder;
+
+    	latency.push_back(now - request.arrival);
+    	(request.write ? writeLatency : readLatency).push_back(now - request.arrival);
+	}
+
+	cout << queue.name() << " Online Scheduling:" << endl;
+	cout << "Average Rotational Delay: " << totalRotationalDelay / requests.size() << " seconds" << endl;
 	cout << "Total Seek Time: " << totalSeekTime << " seconds" << endl;
+	cout << "Total Service Time: " << now << " seconds" << endl;
+	cout << "Latency p50/p95/p99/max: " << percentile(latency, 0.5) << " / " << percentile(latency, 0.95)
+    	 << " / " << percentile(latency, 0.99) << " / " << percentile(latency, 1) << " seconds" << endl;
+	if (!readLatency.empty() && !writeLatency.empty()) {
+    	cout << "Read p99: " << percentile(readLatency, 0.99) << " seconds, Write p99: "
+        	 << percentile(writeLatency, 0.99) << " seconds" << endl;
+	}
 }
 
-int main() {
+
+// Usage: diskscheduling [file] [--lba] [--online] [--nstep n] [--read-expire s]
+//                       [--write-expire s] [--fifo-batch n] [--writes-starved n]
+int main(int argc, char **argv) {
 	int numCylinders, numSectors, bytesPerSector, rpm, initialHeadPosition;
 	double avgSeekTime;
-	vector<int> requests;
+	vector<DiskRequest> requests;
+	string filename = "disk.dat";
+	bool lba = false;
+	bool online = false;
+	size_t nstep = 16;
+	DeadlineConfig deadline;
+
+	for (int i = 1; i < argc; ++i) {
+    	string arg = argv[i];
+    	bool hasValue = i + 1 < argc;
+    	if (arg == "--lba") {
+        	lba = true;
+    	} else if (arg == "--online") {
+        	online = true;
+    	} else if (arg == "--nstep" && hasValue) {
+        	nstep = max(1, stoi(argv[++i]));
+    	} else if (arg == "--read-expire" && hasValue) {
+        	deadline.readExpire = stod(argv[++i]);
+    	} else if (arg == "--write-expire" && hasValue) {
+        	deadline.writeExpire = stod(argv[++i]);
+    	} else if (arg == "--fifo-batch" && hasValue) {
+        	deadline.fifoBatch = max(1, stoi(argv[++i]));
+    	} else if (arg == "--writes-starved" && hasValue) {
+        	deadline.writesStarved = max(0, stoi(argv[++i]));
+    	} else {
+        	filename = arg;
+    	}
+	}
+
+	readDiskParameters(filename, lba, numCylinders, numSectors, bytesPerSector, rpm, avgSeekTime, initialHeadPosition, requests);
+	if (requests.empty()) return 0;
+
+	DiskModel disk = {numCylinders, numSectors, bytesPerSector, rpm, avgSeekTime, initialHeadPosition};
+	SortedRequests sorted = sortRequests(requests, initialHeadPosition);
 
-	readDiskParameters("disk.dat", numCylinders, numSectors, bytesPerSector, rpm, avgSeekTime, initialHeadPosition, requests);
+	fcfsScheduling(requests, disk);
+	sstfScheduling(requests, sorted, disk);
+	lookScheduling(requests, sorted, disk);
+	cscanScheduling(requests, sorted, disk);
+	satfScheduling(requests, disk);
 
-	double rotationalDelay = calculateAverageRotationalDelay(numSectors, rpm);
+	if (online) {
+    	stable_sort(requests.begin(), requests.end(), [](const DiskRequest &a, const DiskRequest &b) {
+        	return a.arrival < b.arrival;
+    	});
+    	for (size_t i = 0; i < requests.size(); ++i) {
+        	requests[i].index = i;
+    	}
 
-	fcfsScheduling(requests, initialHeadPosition, avgSeekTime, rotationalDelay, numSectors);
-	sstfScheduling(requests, initialHeadPosition, avgSeekTime, rotationalDelay, numSectors);
-	lookScheduling(requests, initialHeadPosition, avgSeekTime, rotationalDelay, numSectors);
-	cscanScheduling(requests, initialHeadPosition, avgSeekTime, rotationalDelay, numSectors);
+    	cout << endl;
+    	onlineScheduling(FcfsQueue(), requests, disk);
+    	onlineScheduling(SstfQueue(), requests, disk);
+    	onlineScheduling(SatfQueue(disk, requests), requests, disk);
+    	onlineScheduling(BatchedScanQueue(nstep), requests, disk);
+    	onlineScheduling(BatchedScanQueue(SIZE_MAX), requests, disk);
+    	onlineScheduling(DeadlineQueue(deadline), requests, disk);
+	}
 
 	return 0;
 }
-
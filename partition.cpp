@@ -1,9 +1,19 @@
 #include <iostream>
 #include <fstream>
 #include <vector>
-#include <deque>
+#include <thread>
+#include <set>
+#include <queue>
+#include <tuple>
+#include <array>
+#include <random>
 #include <iomanip>
 #include <algorithm>
+#include <cassert>
+#include <chrono>
+#include <climits>
+#include <string>
+#include <sstream>
 
 struct Request {
 	int time;
@@ -17,136 +27,697 @@ struct Block {
 	bool allocated;
 	int endTime;
 	int allocatedSize;
+	int prev;
+	int next;
 };
 
-void readRequests(const std::string& filename, int& memorySize, std::deque<Request>& requests) {
+int blockSize(const Block& block) {
+	return block.end - block.start + 1;
+}
+
+// Free holes are histogrammed by power-of-two size class: class k counts
+// holes with 2^k <= size < 2^(k+1).
+const int SIZE_CLASSES = 32;
+
+int sizeClass(int size) {
+	assert(size > 0);
+	return 31 - __builtin_clz(size);
+}
+
+// Index over the free blocks. An address-ordered treap whose nodes carry the
+// largest hole in their subtree answers first-fit and next-fit; a set ordered
+// by (size, start) answers best-fit and worst-fit. Every query is O(log n).
+class FreeIndex {
+public:
+	void insert(int start, int size, int block) {
+    	int node = newNode(start, size, block);
+    	int left, right;
+    	split(root, start, left, right);
+    	root = merge(merge(left, node), right);
+    	bySize.insert({size, start, block});
+	}
+
+	void erase(int start, int size, int block) {
+    	int left, mid, right;
+    	split(root, start, left, mid);
+    	split(mid, start + 1, mid, right);
+    	if (mid >= 0) freeSlots.push_back(mid);
+    	root = merge(left, right);
+    	bySize.erase({size, start, block});
+	}
+
+	// Lowest-addressed hole at or after 'from' that holds 'size', or -1
+	int firstFit(int size, int from = 0) const {
+    	int node = findFirst(root, size, from);
+    	return node < 0 ? -1 : nodes[node].block;
+	}
+
+	int bestFit(int size) const {
+    	auto it = bySize.lower_bound({size, -1, -1});
+    	return it == bySize.end() ? -1 : std::get<2>(*it);
+	}
+
+	int worstFit(int size) const {
+    	if (bySize.empty() || std::get<0>(*bySize.rbegin()) < size) return -1;
+    	return std::get<2>(*bySize.rbegin());
+	}
+
+	int largest() const {
+    	return root < 0 ? 0 : nodes[root].maxSize;
+	}
+
+private:
+	struct Node {
+    	int start, size, maxSize, block;
+    	unsigned priority;
+    	int left, right;
+	};
+
+	int newNode(int start, int size, int block) {
+    	Node node = {start, size, size, block, (unsigned)rng(), -1, -1};
+    	if (!freeSlots.empty()) {
+        	int slot = freeSlots.back();
+        	freeSlots.pop_back();
+        	nodes[slot] = node;
+        	return slot;
+    	}
+    	nodes.push_back(node);
+    	return nodes.size() - 1;
+	}
+
+	void update(int t) {
+    	Node& n = nodes[t];
+    	n.maxSize = n.size;
+    	if (n.left >= 0) n.maxSize = std::max(n.maxSize, nodes[n.left].maxSize);
+    	if (n.right >= 0) n.maxSize = std::max(n.maxSize, nodes[n.right].maxSize);
+	}
+
+	// left gets keys < start, right gets keys >= start
+	void split(int t, int start, int& left, int& right) {
+    	if (t < 0) {
+        	left = right = -1;
+    	} else if (nodes[t].start < start) {
+        	split(nodes[t].right, start, nodes[t].right, right);
+        	left = t;
+        	update(t);
+    	} else {
+        	split(nodes[t].left, start, left, nodes[t].left);
+        	right = t;
+        	update(t);
+    	}
+	}
+
+	int merge(int left, int right) {
+    	if (left < 0) return right;
+    	if (right < 0) return left;
+    	if (nodes[left].priority > nodes[right].priority) {
+        	nodes[left].right = merge(nodes[left].right, right);
+        	update(left);
+        	return left;
+    	}
+    	nodes[right].left = merge(left, nodes[right].left);
+    	update(right);
+    	return right;
+	}
+
+	int findFirst(int t, int size, int from) const {
+    	if (t < 0 || nodes[t].maxSize < size) return -1;
+    	const Node& n = nodes[t];
+    	if (n.start >= from) {
+        	int found = findFirst(n.left, size, from);
+        	if (found >= 0) return found;
+        	if (n.size >= size) return t;
+    	}
+    	return findFirst(n.right, size, from);
+	}
+
+	std::vector<Node> nodes;
+	std::vector<int> freeSlots;
+	int root = -1;
+	std::mt19937 rng{12345};
+	std::set<std::tuple<int, int, int>> bySize;
+};
+
+// Reference free list for benchmarking and cross-checking FreeIndex: holes
+// kept as address-ordered parallel arrays, with each query written as a
+// branch-free pass over 'sizes' that the compiler can auto-vectorize.
+// Updates are O(n) memmoves and queries are O(n) scans.
+class FreeScan {
+public:
+	void insert(int start, int size, int block) {
+    	size_t pos = std::lower_bound(starts.begin(), starts.end(), start) - starts.begin();
+    	starts.insert(starts.begin() + pos, start);
+    	sizes.insert(sizes.begin() + pos, size);
+    	blocks.insert(blocks.begin() + pos, block);
+	}
+
+	void erase(int start, int, int) {
+    	size_t pos = std::lower_bound(starts.begin(), starts.end(), start) - starts.begin();
+    	starts.erase(starts.begin() + pos);
+    	sizes.erase(sizes.begin() + pos);
+    	blocks.erase(blocks.begin() + pos);
+	}
+
+	int firstFit(int size, int from = 0) const {
+    	size_t n = sizes.size();
+    	size_t i = std::lower_bound(starts.begin(), starts.end(), from) - starts.begin();
+    	const int* s = sizes.data();
+    	// Test 16 holes at a time so the inner loop has no early exit
+    	for (; i + 16 <= n; i += 16) {
+        	int any = 0;
+        	for (size_t k = 0; k < 16; ++k) any |= s[i + k] >= size;
+        	if (any) break;
+    	}
+    	for (; i < n; ++i) {
+        	if (s[i] >= size) return blocks[i];
+    	}
+    	return -1;
+	}
+
+	// Smallest hole that fits; the lowest address wins a tie, as in FreeIndex
+	int bestFit(int size) const {
+    	const int* s = sizes.data();
+    	int best = INT_MAX;
+    	for (size_t i = 0; i < sizes.size(); ++i) {
+        	int candidate = s[i] >= size ? s[i] : INT_MAX;
+        	best = candidate < best ? candidate : best;
+    	}
+    	if (best == INT_MAX) return -1;
+    	return blocks[std::find(sizes.begin(), sizes.end(), best) - sizes.begin()];
+	}
+
+	// Largest hole; the highest address wins a tie, as in FreeIndex
+	int worstFit(int size) const {
+    	const int* s = sizes.data();
+    	int worst = INT_MIN;
+    	for (size_t i = 0; i < sizes.size(); ++i) {
+        	worst = s[i] > worst ? s[i] : worst;
+    	}
+    	if (worst < size) return -1;
+    	return blocks[sizes.rend() - std::find(sizes.rbegin(), sizes.rend(), worst) - 1];
+	}
+
+	int largest() const {
+    	return sizes.empty() ? 0 : *std::max_element(sizes.begin(), sizes.end());
+	}
+
+private:
+	std::vector<int> starts;
+	std::vector<int> sizes;
+	std::vector<int> blocks;
+};
+
+// Placement policies are types so that allocateBlock and simulate are
+// instantiated, and inlined, once per policy. select() returns the slot of
+// the chosen free block, or -1.
+struct FirstFit {
+	static constexpr const char* name = "First Fit";
+	template <typename Index>
+	static int select(const Index& index, int size, int) {
+    	return index.firstFit(size);
+	}
+};
+
+struct BestFit {
+	static constexpr const char* name = "Best Fit";
+	template <typename Index>
+	static int select(const Index& index, int size, int) {
+    	return index.bestFit(size);
+	}
+};
+
+struct WorstFit {
+	static constexpr const char* name = "Worst Fit";
+	template <typename Index>
+	static int select(const Index& index, int size, int) {
+    	return index.worstFit(size);
+	}
+};
+
+struct NextFit {
+	static constexpr const char* name = "Next Fit";
+	template <typename Index>
+	static int select(const Index& index, int size, int nextFitStart) {
+    	int idx = index.firstFit(size, nextFitStart);
+    	return idx >= 0 ? idx : index.firstFit(size);
+	}
+};
+
+// Blocks live in a slot pool and are chained in address order through
+// prev/next, so a released block merges with free neighbours in O(1) list
+// work plus the index updates. Merged-away slots are recycled.
+template <typename Index = FreeIndex>
+struct Heap {
+	std::vector<Block> blocks;
+	std::vector<int> freeSlots;
+	int head = 0;
+	Index freeIndex;
+	int nextFitStart = 0;
+	std::priority_queue<std::pair<int, int>, std::vector<std::pair<int, int>>,
+                    	std::greater<std::pair<int, int>>> expiries;
+
+	// Running totals, kept current by every allocate, release and merge
+	long usedBytes = 0;
+	long allocatedBytes = 0;
+	long freeBytes = 0;
+	int freeHoles = 0;
+	int holeHistogram[SIZE_CLASSES] = {};
+
+	int memorySize;
+
+	explicit Heap(int memorySize) : memorySize(memorySize) {
+    	blocks.push_back({0, memorySize - 1, false, 0, 0, -1, -1});
+    	addHole(0);
+	}
+
+	int newSlot(const Block& block) {
+    	if (!freeSlots.empty()) {
+        	int slot = freeSlots.back();
+        	freeSlots.pop_back();
+        	blocks[slot] = block;
+        	return slot;
+    	}
+    	blocks.push_back(block);
+    	return blocks.size() - 1;
+	}
+
+	void addHole(int idx) {
+    	int size = blockSize(blocks[idx]);
+    	assert(size > 0);
+    	freeIndex.insert(blocks[idx].start, size, idx);
+    	freeBytes += size;
+    	++freeHoles;
+    	++holeHistogram[sizeClass(size)];
+	}
+
+	void removeHole(int idx) {
+    	int size = blockSize(blocks[idx]);
+    	freeIndex.erase(blocks[idx].start, size, idx);
+    	freeBytes -= size;
+    	--freeHoles;
+    	--holeHistogram[sizeClass(size)];
+	}
+
+	int largestFree() const {
+    	return freeIndex.largest();
+	}
+
+	int blockCount() const {
+    	return blocks.size() - freeSlots.size();
+	}
+
+	// Cuts blocks[idx] down to size, linking the free remainder after it
+	void split(int idx, int size) {
+    	assert(size > 0 && size < blockSize(blocks[idx]));
+    	Block remainder = {blocks[idx].start + size, blocks[idx].end, false, 0, 0, idx, blocks[idx].next};
+    	int slot = newSlot(remainder);
+    	if (remainder.next >= 0) blocks[remainder.next].prev = slot;
+    	blocks[idx].next = slot;
+    	blocks[idx].end = remainder.start - 1;
+    	addHole(slot);
+	}
+
+	void unlink(int idx) {
+    	Block& block = blocks[idx];
+    	if (block.prev >= 0) blocks[block.prev].next = block.next; else head = block.next;
+    	if (block.next >= 0) blocks[block.next].prev = block.prev;
+    	freeSlots.push_back(idx);
+	}
+
+	void release(int idx) {
+    	usedBytes -= blocks[idx].allocatedSize;
+    	allocatedBytes -= blockSize(blocks[idx]);
+    	blocks[idx].allocated = false;
+    	blocks[idx].allocatedSize = 0;
+
+    	int next = blocks[idx].next;
+    	if (next >= 0 && !blocks[next].allocated) {
+        	removeHole(next);
+        	blocks[idx].end = blocks[next].end;
+        	unlink(next);
+    	}
+    	int prev = blocks[idx].prev;
+    	if (prev >= 0 && !blocks[prev].allocated) {
+        	removeHole(prev);
+        	blocks[prev].end = blocks[idx].end;
+        	unlink(idx);
+        	idx = prev;
+    	}
+    	addHole(idx);
+	}
+
+	void releaseExpired(int currentTime) {
+    	while (!expiries.empty() && expiries.top().first <= currentTime) {
+        	release(expiries.top().second);
+        	expiries.pop();
+    	}
+	}
+
+	// Slides every live block down to the lowest free address in a single
+	// sweep of the address-ordered list, leaving one hole at the top.
+	// Live blocks keep their slots, so pending expiries stay valid.
+	// Returns the number of bytes moved.
+	long compact() {
+    	long moved = 0;
+    	int pos = 0;
+    	int last = -1;
+    	for (int idx = head; idx >= 0;) {
+        	int next = blocks[idx].next;
+        	if (blocks[idx].allocated) {
+            	int size = blockSize(blocks[idx]);
+            	if (blocks[idx].start != pos) {
+                	moved += size;
+            	}
+            	blocks[idx].start = pos;
+            	blocks[idx].end = pos + size - 1;
+            	blocks[idx].prev = last;
+            	if (last >= 0) blocks[last].next = idx; else head = idx;
+            	last = idx;
+            	pos += size;
+        	} else {
+            	freeSlots.push_back(idx);
+        	}
+        	idx = next;
+    	}
+
+    	freeIndex = Index();
+    	freeBytes = 0;
+    	freeHoles = 0;
+    	std::fill(holeHistogram, holeHistogram + SIZE_CLASSES, 0);
+    	if (pos < memorySize) {
+        	int hole = newSlot({pos, memorySize - 1, false, 0, 0, last, -1});
+        	if (last >= 0) blocks[last].next = hole; else head = hole;
+        	addHole(hole);
+    	} else {
+        	blocks[last].next = -1;
+    	}
+    	nextFitStart = pos;
+    	return moved;
+	}
+};
+
+void readRequests(const std::string& filename, int& memorySize, std::vector<Request>& requests) {
 	std::ifstream infile(filename);
 	if (!infile) {
     	std::cerr << "Error opening file: " << filename << std::endl;
     	exit(1);
 	}
 	infile >> memorySize;
+	if (memorySize <= 0) {
+    	std::cerr << "Memory size must be positive in " << filename << std::endl;
+    	exit(1);
+	}
 	while (true) {
     	Request req;
-    	infile >> req.time >> req.size >> req.duration;
-    	if (req.time == -1 && req.size == -1 && req.duration == -1) {
+    	if (!(infile >> req.time >> req.size >> req.duration) ||
+        	(req.time == -1 && req.size == -1 && req.duration == -1)) {
         	break;
     	}
+    	if (req.size <= 0) {
+        	std::cerr << "Request sizes must be positive in " << filename << std::endl;
+        	exit(1);
+    	}
     	requests.push_back(req);
 	}
 }
 
-void printMemoryStatus(int successful, int total, int memorySize, const std::vector<Block>& blocks) {
+struct MemoryStatus {
+	double successRate;
+	double freeMemory;
+	double externalFragmentation;
+	double internalFragmentation;
+	int blockCount;
+	int freeHoles;
+	int largestFree;
+	std::array<int, SIZE_CLASSES> holeHistogram;
+	int compactions;
+	long bytesMoved;
+	double compactionTime;
+	int rescued;
+};
+
+// Optional compaction on allocation failure: when the free total would fit
+// the request, live blocks are slid together and the allocation retried.
+// Every byte moved is charged moveCost time units.
+struct CompactionOptions {
+	bool enabled = false;
+	double moveCost = 1.0;
+};
+
+struct CompactionStats {
+	int compactions = 0;
+	long bytesMoved = 0;
+	int rescued = 0;
+};
+
+// O(1): reads the heap's running counters instead of walking the blocks.
+// External fragmentation is the share of free memory outside the largest
+// hole; internal fragmentation is allocated-but-unrequested memory.
+template <typename Index>
+MemoryStatus computeMemoryStatus(int successful, int total, int memorySize, const Heap<Index>& heap,
+                            	 const CompactionStats& compaction, const CompactionOptions& options) {
 	double successRate = (total > 0) ? (100.0 * successful / total) : 0.0;
+	int largest = heap.largestFree();
 
-	int totalUsed = 0;
-	int totalFree = 0;
-	int lastEnd = -1;
+	double freeMemory = (heap.freeBytes * 100.0) / memorySize;
+	double externalFragmentation = heap.freeBytes > 0 ? 100.0 * (heap.freeBytes - largest) / heap.freeBytes : 0.0;
+	double internalFragmentation = ((heap.allocatedBytes - heap.usedBytes) * 100.0) / memorySize;
+	MemoryStatus status = {successRate, freeMemory, externalFragmentation, internalFragmentation,
+                    	   heap.blockCount(), heap.freeHoles, largest, {},
+                    	   compaction.compactions, compaction.bytesMoved,
+                    	   compaction.bytesMoved * options.moveCost, compaction.rescued};
+	std::copy(heap.holeHistogram, heap.holeHistogram + SIZE_CLASSES, status.holeHistogram.begin());
+	return status;
+}
 
-	for (const auto& block : blocks) {
-    	if (block.allocated) {
-        	totalUsed += block.allocatedSize;
-        	lastEnd = block.end;
-    	} else {
-        	if (lastEnd != -1 && block.start > lastEnd + 1) {
-            	totalFree += (block.start - lastEnd - 1);
-        	}
-        	lastEnd = block.end;
-    	}
+template <typename Policy, typename Index>
+bool allocateBlock(Heap<Index>& heap, int size, int currentTime, int duration) {
+	if (size <= 0) {
+    	return false;
 	}
-	if (lastEnd != memorySize - 1) {
-    	totalFree += (memorySize - 1 - lastEnd);
+	int idx = Policy::select(heap.freeIndex, size, heap.nextFitStart);
+	if (idx < 0) {
+    	return false;
 	}
 
-	double externalFragmentation = (totalFree * 100.0) / memorySize;
-	double internalFragmentation = ((totalUsed - totalFree) * 100.0) / memorySize;
-
-	std::cout << "Allocation success rate: " << std::fixed << std::setprecision(2) << successRate << "%\n";
-	std::cout << "External fragmentation: " << externalFragmentation << "%\n";
-	std::cout << "Internal fragmentation: " << internalFragmentation << "%\n";
+	heap.removeHole(idx);
+	if (blockSize(heap.blocks[idx]) > size) {
+    	heap.split(idx, size);
+	}
+	Block& allocated = heap.blocks[idx];
+	heap.usedBytes += size;
+	heap.allocatedBytes += blockSize(allocated);
+	allocated.allocated = true;
+	allocated.allocatedSize = size;
+	allocated.endTime = currentTime + duration;
+	heap.expiries.push({allocated.endTime, idx});
+	heap.nextFitStart = allocated.end + 1;
+	return true;
 }
 
-bool allocateBlock(std::vector<Block>& blocks, int size, int currentTime, int& lastFitIndex, std::function<bool(const Block&, int)> fitStrategy) {
-	int n = blocks.size();
-	int startIdx = lastFitIndex;
-	bool allocated = false;
+const int REPORT_INTERVAL = 10;
+const int NUM_PLACEMENTS = 4;
+const char* placementNames[NUM_PLACEMENTS] = {FirstFit::name, BestFit::name, WorstFit::name, NextFit::name};
 
-	for (int i = 0; i < n; ++i) {
-    	int idx = (startIdx + i) % n;
-    	Block& block = blocks[idx];
-    	if (!block.allocated && fitStrategy(block, size)) {
-        	if ((block.end - block.start + 1) > size) {
-            	blocks.push_back({block.start + size, block.end, false, 0, 0});
-            	block.end = block.start + size - 1;
+// Runs one placement policy on its own heap over the shared request stream,
+// recording a status snapshot every reportInterval requests (0 for none).
+template <typename Policy, typename Index = FreeIndex>
+std::vector<MemoryStatus> simulate(const std::vector<Request>& requests, int memorySize,
+                            	   int reportInterval = REPORT_INTERVAL,
+                            	   const CompactionOptions& compaction = CompactionOptions()) {
+	Heap<Index> heap(memorySize);
+	std::vector<MemoryStatus> snapshots;
+	CompactionStats stats;
+	int successful = 0;
+	int requestCount = 0;
+
+	for (const Request& currentRequest : requests) {
+    	heap.releaseExpired(currentRequest.time);
+
+    	bool allocated = allocateBlock<Policy>(heap, currentRequest.size, currentRequest.time, currentRequest.duration);
+    	if (!allocated && compaction.enabled && heap.freeBytes >= currentRequest.size) {
+        	++stats.compactions;
+        	stats.bytesMoved += heap.compact();
+        	allocated = allocateBlock<Policy>(heap, currentRequest.size, currentRequest.time, currentRequest.duration);
+        	if (allocated) {
+            	++stats.rescued;
         	}
-        	block.allocated = true;
-        	block.allocatedSize = size;
-        	block.endTime = currentTime + size;
-        	lastFitIndex = (idx + 1) % n;
-        	allocated = true;
-        	break;
     	}
+    	if (allocated) {
+        	++successful;
+    	}
+
+    	++requestCount;
+    	if (reportInterval > 0 && requestCount % reportInterval == 0) {
+        	snapshots.push_back(computeMemoryStatus(successful, requestCount, memorySize, heap, stats, compaction));
+    	}
+	}
+	if (reportInterval == 0) {
+    	snapshots.push_back(computeMemoryStatus(successful, requestCount, memorySize, heap, stats, compaction));
 	}
+	return snapshots;
+}
 
-	return allocated;
+// Prints one labelled row with value(p) for each placement policy p
+template <typename Value>
+void printRow(const char* label, Value value, const char* unit) {
+	std::cout << std::setw(26) << std::left << label << std::right;
+	for (int p = 0; p < NUM_PLACEMENTS; ++p) {
+    	std::cout << std::setw(12 - std::char_traits<char>::length(unit)) << value(p) << unit;
+	}
+	std::cout << "\n";
 }
 
-int main() {
-	int memorySize;
-	std::deque<Request> requests;
-	readRequests("alloc.dat", memorySize, requests);
+void printSideBySide(const std::vector<MemoryStatus> (&results)[NUM_PLACEMENTS]) {
+	std::cout << std::fixed << std::setprecision(2);
+	for (size_t snap = 0; snap < results[0].size(); ++snap) {
+    	std::cout << "After " << (snap + 1) * REPORT_INTERVAL << " requests:\n";
+    	std::cout << std::setw(26) << "";
+    	for (int p = 0; p < NUM_PLACEMENTS; ++p) {
+        	std::cout << std::setw(12) << placementNames[p];
+    	}
+    	std::cout << "\n";
+    	printRow("Allocation success rate:", [&](int p) { return results[p][snap].successRate; }, "%");
+    	printRow("Free memory:", [&](int p) { return results[p][snap].freeMemory; }, "%");
+    	printRow("External fragmentation:", [&](int p) { return results[p][snap].externalFragmentation; }, "%");
+    	printRow("Internal fragmentation:", [&](int p) { return results[p][snap].internalFragmentation; }, "%");
+    	printRow("Free holes:", [&](int p) { return results[p][snap].freeHoles; }, "");
+    	printRow("Largest free block:", [&](int p) { return results[p][snap].largestFree; }, "");
+    	printRow("Blocks:", [&](int p) { return results[p][snap].blockCount; }, "");
+	}
 
-	std::vector<Block> blocks = { {0, memorySize - 1, false, 0, 0} };
-	int lastFitIndex = 0;
+	if (results[0].empty()) {
+    	return;
+	}
+	size_t last = results[0].size() - 1;
+	std::cout << "Free hole sizes after " << (last + 1) * REPORT_INTERVAL << " requests:\n";
+	for (int k = 0; k < SIZE_CLASSES; ++k) {
+    	bool any = false;
+    	for (int p = 0; p < NUM_PLACEMENTS; ++p) {
+        	any = any || results[p][last].holeHistogram[k] > 0;
+    	}
+    	if (!any) {
+        	continue;
+    	}
+    	std::string label = "  [" + std::to_string(1L << k) + ", " + std::to_string(1L << (k + 1)) + "):";
+    	printRow(label.c_str(), [&](int p) { return results[p][last].holeHistogram[k]; }, "");
+	}
+}
 
-	int successfulFirstFit = 0, successfulBestFit = 0, successfulWorstFit = 0, successfulNextFit = 0;
-	int requestCount = 0;
+// Compares each policy's final state with and without compaction
+void printCompactionSummary(const std::vector<MemoryStatus> (&results)[NUM_PLACEMENTS],
+                        	const std::vector<MemoryStatus> (&baseline)[NUM_PLACEMENTS],
+                        	const CompactionOptions& compaction) {
+	if (results[0].empty()) {
+    	return;
+	}
+	size_t last = results[0].size() - 1;
+	auto withCompaction = [&](int p) -> const MemoryStatus& { return results[p][last]; };
+	std::cout << "Compaction (move cost " << compaction.moveCost << " per byte):\n";
+	printRow("Compactions:", [&](int p) { return withCompaction(p).compactions; }, "");
+	printRow("Bytes moved:", [&](int p) { return withCompaction(p).bytesMoved; }, "");
+	printRow("Compaction time:", [&](int p) { return withCompaction(p).compactionTime; }, "");
+	printRow("Rescued allocations:", [&](int p) { return withCompaction(p).rescued; }, "");
+	printRow("Success without:", [&](int p) { return baseline[p][last].successRate; }, "%");
+	printRow("Success with:", [&](int p) { return withCompaction(p).successRate; }, "%");
+	// n/a when compaction bought no success at all, which may have cost time
+	printRow("Time per +1% success:", [&](int p) {
+    	double gain = withCompaction(p).successRate - baseline[p][last].successRate;
+    	if (gain <= 0) {
+        	return std::string("n/a");
+    	}
+    	std::ostringstream ratio;
+    	ratio << std::fixed << std::setprecision(2) << withCompaction(p).compactionTime / gain;
+    	return ratio.str();
+	}, "");
+}
 
-	auto firstFitStrategy = [](const Block& block, int size) {
-    	return (block.end - block.start + 1) >= size;
-	};
+// Synthetic alloc.dat-style stream: one request per time unit with lifetimes
+// long enough to keep tens of thousands of blocks live.
+std::vector<Request> syntheticRequests(int count, unsigned seed) {
+	std::mt19937 rng(seed);
+	std::geometric_distribution<int> size(0.002);
+	std::uniform_int_distribution<int> duration(1, 60000);
+	std::vector<Request> requests(count);
+	for (int i = 0; i < count; ++i) {
+    	requests[i] = {i, 1 + size(rng), duration(rng)};
+	}
+	return requests;
+}
 
-	auto bestFitStrategy = [memorySize](const Block& block, int size) {
-    	return (block.end - block.start + 1) >= size;
-	};
+template <typename Policy, typename Index>
+double timeSimulation(const std::vector<Request>& requests, int memorySize, MemoryStatus& status) {
+	auto begin = std::chrono::steady_clock::now();
+	status = simulate<Policy, Index>(requests, memorySize, 0).back();
+	return std::chrono::duration<double>(std::chrono::steady_clock::now() - begin).count();
+}
 
-	auto worstFitStrategy = [memorySize](const Block& block, int size) {
-    	return (block.end - block.start + 1) >= size;
-	};
+template <typename Policy>
+void benchmarkPolicy(const std::vector<Request>& requests, int memorySize) {
+	MemoryStatus indexed, scanned;
+	double indexTime = timeSimulation<Policy, FreeIndex>(requests, memorySize, indexed);
+	double scanTime = timeSimulation<Policy, FreeScan>(requests, memorySize, scanned);
+	std::cout << std::setw(10) << Policy::name << std::fixed << std::setprecision(3)
+        	  << std::setw(12) << scanTime << std::setw(12) << indexTime
+        	  << std::setw(9) << std::setprecision(1) << scanTime / indexTime << "x"
+        	  << (indexed.successRate == scanned.successRate ? "" : "   MISMATCH") << "\n";
+}
 
-	while (!requests.empty()) {
-    	Request currentRequest = requests.front();
-    	requests.pop_front();
+void runBenchmark(const std::vector<Request>& requests, int memorySize) {
+	std::cout << "Requests: " << requests.size() << ", memory: " << memorySize << "\n";
+	std::cout << "    Policy     scan(s)    index(s)  speedup\n";
+	benchmarkPolicy<FirstFit>(requests, memorySize);
+	benchmarkPolicy<BestFit>(requests, memorySize);
+	benchmarkPolicy<WorstFit>(requests, memorySize);
+	benchmarkPolicy<NextFit>(requests, memorySize);
+}
 
-    	for (auto& block : blocks) {
-        	if (block.allocated && block.endTime <= currentRequest.time) {
-            	block.allocated = false;
-            	block.allocatedSize = 0;
-        	}
+int main(int argc, char** argv) {
+	if (argc > 1 && std::string(argv[1]) == "--bench") {
+    	int memorySize = 1 << 26;
+    	std::vector<Request> requests;
+    	if (argc > 2) {
+        	readRequests(argv[2], memorySize, requests);
+    	} else {
+        	requests = syntheticRequests(200000, 1);
     	}
+    	runBenchmark(requests, memorySize);
+    	return 0;
+	}
 
-    	bool allocatedFirstFit = allocateBlock(blocks, currentRequest.size, currentRequest.time, lastFitIndex, firstFitStrategy);
-    	bool allocatedBestFit = allocateBlock(blocks, currentRequest.size, currentRequest.time, lastFitIndex, bestFitStrategy);
-    	bool allocatedWorstFit = allocateBlock(blocks, currentRequest.size, currentRequest.time, lastFitIndex, worstFitStrategy);
-    	bool allocatedNextFit = allocateBlock(blocks, currentRequest.size, currentRequest.time, lastFitIndex, worstFitStrategy);  
-    	if (allocatedFirstFit) ++successfulFirstFit;
-    	if (allocatedBestFit) ++successfulBestFit;
-    	if (allocatedWorstFit) ++successfulWorstFit;
-    	if (allocatedNextFit) ++successfulNextFit;
-
-    	++requestCount;
-    	if (requestCount % 10 == 0) {
-        	std::cout << "After " << requestCount << " requests:\n";
-        	std::cout << "First Fit:\n";
-        	printMemoryStatus(successfulFirstFit, requestCount, memorySize, blocks);
-        	std::cout << "Best Fit:\n";
-        	printMemoryStatus(successfulBestFit, requestCount, memorySize, blocks);
-        	std::cout << "Worst Fit:\n";
-        	printMemoryStatus(successfulWorstFit, requestCount, memorySize, blocks);
-        	std::cout << "Next Fit:\n";
-        	printMemoryStatus(successfulNextFit, requestCount, memorySize, blocks);
+	CompactionOptions compaction;
+	if (argc > 1 && std::string(argv[1]) == "--compact") {
+    	compaction.enabled = true;
+    	if (argc > 2) {
+        	compaction.moveCost = std::stod(argv[2]);
     	}
 	}
 
+	int memorySize;
+	std::vector<Request> requests;
+	readRequests("alloc.dat", memorySize, requests);
+
+	std::vector<MemoryStatus> results[NUM_PLACEMENTS];
+	std::vector<MemoryStatus> baseline[NUM_PLACEMENTS];
+	std::vector<std::thread> workers;
+	workers.emplace_back([&] { results[0] = simulate<FirstFit>(requests, memorySize, REPORT_INTERVAL, compaction); });
+	workers.emplace_back([&] { results[1] = simulate<BestFit>(requests, memorySize, REPORT_INTERVAL, compaction); });
+	workers.emplace_back([&] { results[2] = simulate<WorstFit>(requests, memorySize, REPORT_INTERVAL, compaction); });
+	workers.emplace_back([&] { results[3] = simulate<NextFit>(requests, memorySize, REPORT_INTERVAL, compaction); });
+	if (compaction.enabled) {
+    	workers.emplace_back([&] { baseline[0] = simulate<FirstFit>(requests, memorySize); });
+    	workers.emplace_back([&] { baseline[1] = simulate<BestFit>(requests, memorySize); });
+    	workers.emplace_back([&] { baseline[2] = simulate<WorstFit>(requests, memorySize); });
+    	workers.emplace_back([&] { baseline[3] = simulate<NextFit>(requests, memorySize); });
+	}
+	for (auto& worker : workers) {
+    	worker.join();
+	}
+
+	printSideBySide(results);
+	if (compaction.enabled) {
+    	printCompactionSummary(results, baseline, compaction);
+	}
+
 	return 0;
 }
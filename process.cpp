@@ -1,200 +1,924 @@
 #include <iostream>
 #include <fstream>
 #include <sstream>
+#include <iomanip>
 #include <vector>
+#include <deque>
 #include <queue>
+#include <string>
 #include <algorithm>
+#include <climits>
+#include <cmath>
+#include <cctype>
+#include <cstdint>
+#include <random>
+#include <thread>
+#include <atomic>
+#include <chrono>
+#include <charconv>
+#include <cstring>
+#include "chrome_trace.h"
 using namespace std;
 
-struct Process {
-    int id, priority, arrival_time;
+// Process table of a workload, one array per field. The bursts of all
+// processes are stored back to back in one arena: process i owns
+// burst_count[i] bursts starting at bursts[burst_offset[i]]. Loading a
+// workload therefore costs a handful of growing arrays instead of one
+// allocation per process. Simulations only read the workload, so any number
+// of runs can share one.
+struct Workload {
+    vector<int> id, priority, arrival_time;
+    vector<int> burst_offset, burst_count;
     vector<int> bursts;
-    int current_burst = 0;
-    int time_remaining = 0;
-    int wait_time = 0;
-    string history;
+
+    int size() const { return id.size(); }
+
+    int burst(int pid, int i) const { return bursts[burst_offset[pid] + i]; }
+
+    void reserve(int n) {
+        id.reserve(n);
+        priority.reserve(n);
+        arrival_time.reserve(n);
+        burst_offset.reserve(n);
+        burst_count.reserve(n);
+    }
+
+    // Starts a new process; its bursts follow through add_burst
+    void add_process(int pid, int prio, int arrival) {
+        id.push_back(pid);
+        priority.push_back(prio);
+        arrival_time.push_back(arrival);
+        burst_offset.push_back(bursts.size());
+        burst_count.push_back(0);
+    }
+
+    void add_burst(int length) {
+        bursts.push_back(length);
+        burst_count.back()++;
+    }
 };
 
-vector<Process> processes;
-queue<int> ready_queue;
-vector<int> io_queue;
+enum class Policy { FCFS, SJF, PRIORITY, RR, MLFQ };
 
-void read_input() {
-    ifstream file("proc.dat");
-    string line;
-    getline(file, line);
-    int n = stoi(line);
-    
-    for (int i = 0; i < n; ++i) {
-        getline(file, line);
-        stringstream ss(line);
-        Process p;
-        string token;
-        getline(ss, token, ',');
-        p.id = stoi(token);
-        getline(ss, token, ',');
-        p.priority = stoi(token);
-        getline(ss, token, ',');
-        p.arrival_time = stoi(token);
-        while (getline(ss, token, ',')) {
-            int burst = stoi(token);
-            if (burst == -1) break;
-            p.bursts.push_back(burst);
-        }
-        processes.push_back(p);
+const Policy POLICIES[] = {Policy::FCFS, Policy::SJF, Policy::PRIORITY, Policy::RR, Policy::MLFQ};
+const char *const POLICY_NAMES[] = {"fcfs", "sjf", "priority", "rr", "mlfq"};
+const int POLICY_COUNT = 5;
+
+const int TIME_QUANTUM = 4;
+
+// Multilevel feedback queue settings: one quantum per level, top level
+// first (at most 64 levels), and the period of the priority boost that
+// moves every process back to the top level.
+struct MlfqConfig {
+    vector<long> quanta = {4, 8, 16};
+    long boost_interval = 100;
+};
+
+// A run of one state in a process history. Segments of all processes share
+// one pool and are chained per process through next.
+struct Segment {
+    char state;
+    int pid;
+    long start, length;
+    int next;
+};
+
+// Parses the next integer before end, skipping the separators in front of it
+bool next_int(const char *&pos, const char *end, int &value) {
+    while (pos < end && *pos != '-' && !isdigit((unsigned char)*pos)) pos++;
+    from_chars_result result = from_chars(pos, end, value);
+    if (result.ec != errc()) return false;
+    pos = result.ptr;
+    return true;
+}
+
+// Reads the whole file in one go and parses it in place; lines are
+// "id,priority,arrival,burst,...,-1". Returns false if the file cannot be
+// read.
+bool read_input(Workload &workload, const string &path = "proc.dat") {
+    ifstream file(path, ios::binary | ios::ate);
+    streamoff size = file ? (streamoff)file.tellg() : -1;
+    // A directory opens, but reports a bogus size and fails the first read
+    if (size < 0 || !file.seekg(0) || (size > 0 && file.peek() == char_traits<char>::eof())) {
+        cerr << "Cannot read " << path << endl;
+        return false;
+    }
+    string text(size, '\0');
+    if (!file.read(&text[0], text.size())) {
+        cerr << "Cannot read " << path << endl;
+        return false;
     }
     file.close();
-}
 
-void update_io(int time) {
-    vector<int> remaining_io;
-    for (int i = 0; i < io_queue.size(); ++i) {
-        int pid = io_queue[i];
-        processes[pid].bursts[processes[pid].current_burst]--;
-        processes[pid].history += "R";
-        if (processes[pid].bursts[processes[pid].current_burst] == 0) {
-            processes[pid].current_burst++;
-            ready_queue.push(pid);
-        } else {
-            remaining_io.push_back(pid);
+    const char *pos = text.data(), *end = pos + text.size();
+    int n = 0;
+    if (!next_int(pos, end, n)) return true;
+    workload.reserve(n);
+    workload.bursts.reserve(text.size() / 4);
+    for (int i = 0; i < n; ++i) {
+        pos = (const char *)memchr(pos, '\n', end - pos);
+        if (!pos) break;
+        pos++;
+        const char *line_end = (const char *)memchr(pos, '\n', end - pos);
+        if (!line_end) line_end = end;
+        int id, priority, arrival, burst;
+        if (!next_int(pos, line_end, id) || !next_int(pos, line_end, priority) ||
+            !next_int(pos, line_end, arrival)) break;
+        workload.add_process(id, priority, arrival);
+        while (next_int(pos, line_end, burst) && burst != -1) {
+            workload.add_burst(burst);
         }
+        pos = line_end;
     }
-    io_queue = remaining_io;
+    return true;
 }
 
-void fcfs() {
-    int time = 0;
-    while (!ready_queue.empty() || !io_queue.empty()) {
-        update_io(time);
-        if (!ready_queue.empty()) {
-            int pid = ready_queue.front();
-            ready_queue.pop();
-            Process &p = processes[pid];
-            if (p.arrival_time > time) {
-                time = p.arrival_time;
+// Binary min-heap over process ids with a position index, giving O(log n)
+// push, pop, erase and key update. Equal keys are served in insertion order.
+class IndexedHeap {
+public:
+    void resize(int n) {
+        keys.assign(n, {0, 0});
+        pos.assign(n, -1);
+        heap.clear();
+    }
+
+    bool empty() const { return heap.empty(); }
+    int top() const { return heap[0]; }
+
+    void push(int pid, long key) {
+        keys[pid] = {key, next_seq++};
+        pos[pid] = heap.size();
+        heap.push_back(pid);
+        sift_up(pos[pid]);
+    }
+
+    void update(int pid, long key) {
+        bool decreased = key < keys[pid].first;
+        keys[pid].first = key;
+        if (decreased) sift_up(pos[pid]); else sift_down(pos[pid]);
+    }
+
+    void erase(int pid) {
+        int i = pos[pid];
+        swap_at(i, heap.size() - 1);
+        heap.pop_back();
+        pos[pid] = -1;
+        if (i < (int)heap.size()) {
+            sift_up(i);
+            sift_down(i);
+        }
+    }
+
+private:
+    bool less_at(int i, int j) const {
+        return keys[heap[i]] < keys[heap[j]];
+    }
+
+    void swap_at(int i, int j) {
+        swap(heap[i], heap[j]);
+        pos[heap[i]] = i;
+        pos[heap[j]] = j;
+    }
+
+    void sift_up(int i) {
+        while (i > 0 && less_at(i, (i - 1) / 2)) {
+            swap_at(i, (i - 1) / 2);
+            i = (i - 1) / 2;
+        }
+    }
+
+    void sift_down(int i) {
+        int n = heap.size();
+        while (true) {
+            int best = i, l = 2 * i + 1, r = l + 1;
+            if (l < n && less_at(l, best)) best = l;
+            if (r < n && less_at(r, best)) best = r;
+            if (best == i) return;
+            swap_at(i, best);
+            i = best;
+        }
+    }
+
+    vector<pair<long, long>> keys;
+    vector<int> pos;
+    vector<int> heap;
+    long next_seq = 0;
+};
+
+enum EventType { IO_DONE, CPU_DONE, QUANTUM_EXPIRED, BOOST };
+
+struct Event {
+    long time;
+    long seq;
+    EventType type;
+    int pid;
+    bool operator>(const Event &e) const {
+        return time > e.time || (time == e.time && seq > e.seq);
+    }
+};
+
+// FIFO queue per MLFQ level, threaded through one next-link per process.
+// Enqueue, dequeue and splicing a whole level are O(1); a bitmask of
+// non-empty levels finds the highest one with find-first-set.
+class LevelQueues {
+public:
+    void resize(int levels, int n) {
+        head.assign(levels, -1);
+        tail.assign(levels, -1);
+        link.assign(n, -1);
+        nonempty = 0;
+    }
+
+    bool empty() const { return nonempty == 0; }
+    int top_level() const { return __builtin_ctzll(nonempty); }
+
+    void push_back(int level, int pid) {
+        link[pid] = -1;
+        if (tail[level] >= 0) link[tail[level]] = pid; else head[level] = pid;
+        tail[level] = pid;
+        nonempty |= 1ULL << level;
+    }
+
+    int pop_front(int level) {
+        int pid = head[level];
+        head[level] = link[pid];
+        if (head[level] < 0) {
+            tail[level] = -1;
+            nonempty &= ~(1ULL << level);
+        }
+        return pid;
+    }
+
+    // Appends every lower level, in order, to the top level
+    void splice_into_top() {
+        for (int level = 1; level < (int)head.size(); ++level) {
+            if (head[level] < 0) continue;
+            if (tail[0] >= 0) link[tail[0]] = head[level]; else head[0] = head[level];
+            tail[0] = tail[level];
+            head[level] = tail[level] = -1;
+        }
+        if (nonempty) nonempty = 1;
+    }
+
+private:
+    vector<int> head, tail, link;
+    uint64_t nonempty = 0;
+};
+
+// Discrete-event engine shared by all policies. Time jumps straight to the
+// next arrival, burst completion, quantum expiry or I/O completion, so the
+// cost grows with the number of events rather than with total burst time.
+// Even-numbered bursts are CPU bursts and odd-numbered ones are I/O.
+//
+// FCFS and RR keep a FIFO ready queue. SJF (shortest remaining time) and
+// preemptive priority keep every runnable process, including the running
+// one, in an IndexedHeap: the running process's key is lowered as it
+// consumes its burst, and a preemption is simply a different heap top.
+//
+// MLFQ admits processes at the top level and demotes one a level once it
+// has used up that level's quantum, counted across I/O waits. A process
+// becoming ready on a higher level preempts the running one, and every
+// boost_interval all processes return to the top level. The boost is O(1)
+// for any number of processes: the level queues are spliced and per-process
+// levels are reset lazily by comparing against a boost epoch.
+//
+// A Simulation owns all of its run state and only reads its workload, so
+// independent simulations can run concurrently on different threads.
+class Simulation {
+public:
+    Simulation(const Workload &workload, Policy policy, const MlfqConfig &mlfq = MlfqConfig())
+        : workload(workload), policy(policy), mlfq(mlfq) {}
+
+    void run() {
+        int n = workload.size();
+        current_burst.assign(n, 0);
+        time_remaining.assign(n, 0);
+        waited.assign(n, 0);
+        finish_time.assign(n, 0);
+        state_since.assign(n, 0);
+        history_head.assign(n, -1);
+        history_tail.assign(n, -1);
+        state.assign(n, ' ');
+        runnable.resize(n);
+        levels.resize(mlfq.quanta.size(), n);
+        level.assign(n, 0);
+        level_used.assign(n, 0);
+        level_epoch.assign(n, 0);
+        // Arrivals are consumed in order from a sorted list rather than
+        // through the event heap, which then only holds the few in-flight
+        // events. Processes arriving together are admitted in id order,
+        // ahead of any other event at the same time.
+        vector<int> arrivals;
+        arrivals.reserve(n);
+        for (int pid = 0; pid < n; ++pid) {
+            if (workload.burst_count[pid] > 0) arrivals.push_back(pid);
+        }
+        stable_sort(arrivals.begin(), arrivals.end(), [&](int a, int b) {
+            return workload.arrival_time[a] < workload.arrival_time[b];
+        });
+        active = arrivals.size();
+        if (policy == Policy::MLFQ && active > 0) {
+            push_event(mlfq.boost_interval, BOOST, -1);
+        }
+        size_t next_arrival = 0;
+        while (next_arrival < arrivals.size() || !events.empty()) {
+            long now = LONG_MAX;
+            if (next_arrival < arrivals.size()) now = workload.arrival_time[arrivals[next_arrival]];
+            if (!events.empty()) now = min(now, events.top().time);
+            while (next_arrival < arrivals.size() && workload.arrival_time[arrivals[next_arrival]] == now) {
+                make_ready(arrivals[next_arrival++], now);
             }
-            p.history += string(time - p.history.size(), 'W');
-            p.history += "C";
-            time++;
-            p.bursts[p.current_burst]--;
-            if (p.bursts[p.current_burst] == 0) {
-                p.current_burst++;
-                if (p.current_burst < p.bursts.size()) {
-                    io_queue.push(pid);
-                }
-            } else {
-                ready_queue.push(pid);
+            while (!events.empty() && events.top().time == now) {
+                Event e = events.top();
+                events.pop();
+                handle(e, now);
             }
-        } else {
-            time++;
+            dispatch(now);
         }
     }
-}
 
-void sjf_preemptive() {
-    int time = 0;
-    while (!ready_queue.empty() || !io_queue.empty()) {
-        update_io(time);
-        if (!ready_queue.empty()) {
-            sort(ready_queue.front(), ready_queue.back(), [](int a, int b) {
-                return processes[a].bursts[processes[a].current_burst] < processes[b].bursts[processes[b].current_burst];
-            });
-            int pid = ready_queue.front();
-            ready_queue.pop();
-            Process &p = processes[pid];
-            if (p.arrival_time > time) {
-                time = p.arrival_time;
+    long wait_time(int pid) const { return waited[pid]; }
+
+    long turnaround(int pid) const {
+        return finish_time[pid] - workload.arrival_time[pid];
+    }
+
+    // Expands the segments overlapping [from, to) into one char per time unit
+    void display_history(long from = 0, long to = LONG_MAX) const {
+        for (int pid = 0; pid < workload.size(); ++pid) {
+            cout << "Process " << workload.id[pid] << ": ";
+            long pos = from;
+            for (int idx = history_head[pid]; idx >= 0 && pos < to; idx = history_pool[idx].next) {
+                const Segment &seg = history_pool[idx];
+                long begin = max(seg.start, from), end = min(seg.start + seg.length, to);
+                if (end <= begin) continue;
+                cout << string(begin - pos, ' ') << string(end - begin, seg.state);
+                pos = end;
             }
-            p.history += string(time - p.history.size(), 'W');
-            p.history += "C";
-            time++;
-            p.bursts[p.current_burst]--;
-            if (p.bursts[p.current_burst] == 0) {
-                p.current_burst++;
-                if (p.current_burst < p.bursts.size()) {
-                    io_queue.push(pid);
-                }
-            } else {
-                ready_queue.push(pid);
+            cout << endl;
+        }
+    }
+
+    // Writes the schedule with one tick per microsecond: a CPU track with a
+    // slice per process on the CPU, and a track per process with its
+    // ready, running and I/O segments. The pool is streamed in storage
+    // order rather than per process, since trace events need no ordering.
+    void write_trace(ChromeTraceWriter &trace) const {
+        trace.process_name(1, "CPU");
+        trace.thread_name(1, 0, "CPU 0");
+        trace.process_name(2, "Processes");
+        for (int pid = 0; pid < workload.size(); ++pid) {
+            trace.thread_name(2, pid, "Process ", workload.id[pid]);
+        }
+        for (const Segment &seg : history_pool) {
+            const char *label = seg.state == 'C' ? "Running" : seg.state == 'W' ? "Ready" : "I/O";
+            trace.slice(2, seg.pid, label, -1, seg.start, seg.length);
+            if (seg.state == 'C') trace.slice(1, 0, "P", workload.id[seg.pid], seg.start, seg.length);
+        }
+    }
+
+private:
+    // Each state change closes one run-length segment, so history grows
+    // with the number of state changes, not with elapsed time.
+    void append_history(int pid, char s, long start, long length) {
+        if (length == 0 || s == ' ') return;
+        int last = history_tail[pid];
+        if (last >= 0) {
+            Segment &tail = history_pool[last];
+            if (tail.state == s && tail.start + tail.length == start) {
+                tail.length += length;
+                return;
             }
+        }
+        history_pool.push_back({s, pid, start, length, -1});
+        int idx = history_pool.size() - 1;
+        if (last >= 0) history_pool[last].next = idx; else history_head[pid] = idx;
+        history_tail[pid] = idx;
+    }
+
+    void set_state(int pid, char s, long time) {
+        append_history(pid, state[pid], state_since[pid], time - state_since[pid]);
+        if (state[pid] == 'W') waited[pid] += time - state_since[pid];
+        state[pid] = s;
+        state_since[pid] = time;
+    }
+
+    void push_event(long time, EventType type, int pid) {
+        events.push({time, next_seq++, type, pid});
+    }
+
+    void make_ready(int pid, long now) {
+        time_remaining[pid] = workload.burst(pid, current_burst[pid]);
+        set_state(pid, 'W', now);
+        enqueue(pid);
+    }
+
+    void enqueue(int pid) {
+        if (preemptive()) {
+            runnable.push(pid, key(pid));
+        } else if (policy == Policy::MLFQ) {
+            levels.push_back(level_of(pid), pid);
         } else {
-            time++;
+            ready.push_back(pid);
         }
     }
-}
 
-void priority_preemptive() {
-    int time = 0;
-    while (!ready_queue.empty() || !io_queue.empty()) {
-        update_io(time);
-        if (!ready_queue.empty()) {
-            sort(ready_queue.front(), ready_queue.back(), [](int a, int b) {
-                return processes[a].priority < processes[b].priority;
-            });
-            int pid = ready_queue.front();
-            ready_queue.pop();
-            Process &p = processes[pid];
-            if (p.arrival_time > time) {
-                time = p.arrival_time;
-            }
-            p.history += string(time - p.history.size(), 'W');
-            p.history += "C";
-            time++;
-            p.bursts[p.current_burst]--;
-            if (p.bursts[p.current_burst] == 0) {
-                p.current_burst++;
-                if (p.current_burst < p.bursts.size()) {
-                    io_queue.push(pid);
-                }
+    int level_of(int pid) {
+        if (level_epoch[pid] != boost_epoch) {
+            level[pid] = 0;
+            level_used[pid] = 0;
+            level_epoch[pid] = boost_epoch;
+        }
+        return level[pid];
+    }
+
+    // Moves a process whose current burst just ended on to its next burst
+    void next_burst(int pid, long now) {
+        int burst = ++current_burst[pid];
+        if (burst >= workload.burst_count[pid]) {
+            set_state(pid, ' ', now);
+            finish_time[pid] = now;
+            active--;
+        } else if (burst % 2 == 0) {
+            make_ready(pid, now);
+        } else {
+            set_state(pid, 'R', now);
+            push_event(now + workload.burst(pid, burst), IO_DONE, pid);
+        }
+    }
+
+    void handle(const Event &e, long now) {
+        switch (e.type) {
+        case IO_DONE:
+            next_burst(e.pid, now);
+            break;
+        case CPU_DONE:
+        case QUANTUM_EXPIRED:
+            if (e.pid != running || e.seq != run_event) break;
+            stop_running(now);
+            if (time_remaining[e.pid] == 0) {
+                if (preemptive()) runnable.erase(e.pid);
+                next_burst(e.pid, now);
             } else {
-                ready_queue.push(pid);
+                set_state(e.pid, 'W', now);
+                enqueue(e.pid);
+            }
+            break;
+        case BOOST:
+            boost(now);
+            break;
+        }
+    }
+
+    void boost(long now) {
+        int pid = running;
+        if (pid >= 0) stop_running(now);
+        boost_epoch++;
+        levels.splice_into_top();
+        if (pid >= 0) start(pid, now);
+        if (active > 0) push_event(now + mlfq.boost_interval, BOOST, -1);
+    }
+
+    void stop_running(long now) {
+        int pid = running;
+        long ran = now - run_start;
+        time_remaining[pid] -= ran;
+        running = -1;
+        if (policy == Policy::MLFQ) {
+            int l = level_of(pid);
+            level_used[pid] += ran;
+            if (level_used[pid] >= mlfq.quanta[l]) {
+                level[pid] = min(l + 1, (int)mlfq.quanta.size() - 1);
+                level_used[pid] = 0;
             }
+        }
+    }
+
+    bool preemptive() const {
+        return policy == Policy::SJF || policy == Policy::PRIORITY;
+    }
+
+    long key(int pid) const {
+        return policy == Policy::SJF ? time_remaining[pid] : workload.priority[pid];
+    }
+
+    void start(int pid, long now) {
+        set_state(pid, 'C', now);
+        running = pid;
+        run_start = now;
+        run_event = next_seq;
+        long remaining = time_remaining[pid];
+        long slice = remaining;
+        if (policy == Policy::RR) {
+            slice = TIME_QUANTUM;
+        } else if (policy == Policy::MLFQ) {
+            int l = level_of(pid);
+            slice = mlfq.quanta[l] - level_used[pid];
+        }
+        if (slice < remaining) {
+            push_event(now + slice, QUANTUM_EXPIRED, pid);
         } else {
-            time++;
+            push_event(now + remaining, CPU_DONE, pid);
         }
     }
-}
 
-void round_robin() {
-    int time = 0;
-    while (!ready_queue.empty() || !io_queue.empty()) {
-        update_io(time);
-        if (!ready_queue.empty()) {
-            int pid = ready_queue.front();
-            ready_queue.pop();
-            Process &p = processes[pid];
-            if (p.arrival_time > time) {
-                time = p.arrival_time;
+    void dispatch(long now) {
+        if (preemptive()) {
+            if (running >= 0) {
+                time_remaining[running] -= now - run_start;
+                run_start = now;
+                if (policy == Policy::SJF) runnable.update(running, key(running));
             }
-            p.history += string(time - p.history.size(), 'W');
-            p.history += "C";
-            time++;
-            p.bursts[p.current_burst]--;
-            if (p.bursts[p.current_burst] == 0) {
-                p.current_burst++;
-                if (p.current_burst < p.bursts.size()) {
-                    io_queue.push(pid);
-                }
-            } else {
-                ready_queue.push(pid);
+            if (runnable.empty() || runnable.top() == running) return;
+            if (running >= 0) {
+                set_state(running, 'W', now);
+                running = -1;
             }
-        } else {
-            time++;
+            start(runnable.top(), now);
+            return;
+        }
+
+        if (policy == Policy::MLFQ) {
+            if (levels.empty()) return;
+            if (running >= 0) {
+                if (levels.top_level() >= level_of(running)) return;
+                int preempted = running;
+                stop_running(now);
+                set_state(preempted, 'W', now);
+                enqueue(preempted);
+            }
+            start(levels.pop_front(levels.top_level()), now);
+            return;
         }
+
+        if (running >= 0 || ready.empty()) return;
+        int pid = ready.front();
+        ready.pop_front();
+        start(pid, now);
     }
+
+    const Workload &workload;
+    // Per-run process state, indexed like the workload arrays. History
+    // states: 'W' ready, 'C' on the CPU, 'R' in I/O, ' ' not arrived or
+    // finished.
+    vector<int> current_burst;
+    vector<long> time_remaining, waited, finish_time, state_since;
+    vector<int> history_head, history_tail;
+    vector<char> state;
+    vector<Segment> history_pool;
+    Policy policy;
+    MlfqConfig mlfq;
+    priority_queue<Event, vector<Event>, greater<Event>> events;
+    long next_seq = 0;
+    deque<int> ready;
+    IndexedHeap runnable;
+    LevelQueues levels;
+    vector<int> level;
+    vector<long> level_used, level_epoch;
+    long boost_epoch = 0;
+    int active = 0;
+    int running = -1;
+    long run_start = 0;
+    long run_event = -1;
+};
+
+Policy parse_policy(const string &name) {
+    for (int i = 0; i < POLICY_COUNT; ++i) {
+        if (name == POLICY_NAMES[i]) return POLICIES[i];
+    }
+    return Policy::FCFS;
 }
 
-void display_history() {
-    for (auto &p : processes) {
-        cout << "Process " << p.id << ": " << p.history << endl;
+vector<long> parse_list(const string &text) {
+    vector<long> values;
+    stringstream ss(text);
+    string token;
+    while (getline(ss, token, ',')) {
+        values.push_back(stol(token));
     }
+    return values;
 }
 
-int main() {
-    read_input();
-    ready_queue.push(0);
-    fcfs();
-    display_history();
-    return 0;
+enum class Distribution { EXPONENTIAL, UNIFORM, FIXED };
+
+const char *const DISTRIBUTION_NAMES[] = {"exp", "uniform", "fixed"};
+
+// A random length with the given mean: exponential, uniform over
+// [0, 2 * mean], or always the mean
+struct LengthDistribution {
+    Distribution kind;
+    double mean;
+
+    double operator()(mt19937_64 &rng) const {
+        switch (kind) {
+        case Distribution::EXPONENTIAL: return exponential_distribution<double>(1.0 / mean)(rng);
+        case Distribution::UNIFORM: return uniform_real_distribution<double>(0, 2 * mean)(rng);
+        case Distribution::FIXED: return mean;
+        }
+        return mean;
+    }
+};
+
+// Parses "mean" (exponential) or "name:mean", e.g. "uniform:20"
+bool parse_distribution(const string &text, LengthDistribution &dist) {
+    size_t colon = text.find(':');
+    dist = {Distribution::EXPONENTIAL, stod(text.substr(colon == string::npos ? 0 : colon + 1))};
+    if (colon == string::npos) return true;
+    for (int i = 0; i < 3; ++i) {
+        if (text.compare(0, colon, DISTRIBUTION_NAMES[i]) == 0) {
+            dist.kind = Distribution(i);
+            return true;
+        }
+    }
+    return false;
+}
+
+// Synthetic workload shape for the sweep. Interarrival times and burst
+// lengths are drawn from their distributions (bursts are at least one unit
+// long), each process has 1 to max_cpu_bursts CPU bursts with an I/O burst
+// between consecutive ones, and priorities are uniform in 0-9. Workload i
+// is generated from seed + i, so a sweep is reproducible for any thread
+// count.
+struct SweepConfig {
+    int workloads = 1000;
+    int threads = max(1u, thread::hardware_concurrency());
+    uint64_t seed = 1;
+    int processes = 50;
+    LengthDistribution arrival = {Distribution::EXPONENTIAL, 20};
+    LengthDistribution cpu = {Distribution::EXPONENTIAL, 6};
+    LengthDistribution io = {Distribution::EXPONENTIAL, 10};
+    int max_cpu_bursts = 5;
+};
+
+// Rounds up, so a fixed length is kept exactly and a draw is never below
+// one unit
+int burst_length(double draw) {
+    return max(1, (int)ceil(draw));
 }
 
+Workload generate_workload(const SweepConfig &config, uint64_t seed) {
+    mt19937_64 rng(seed);
+    uniform_int_distribution<int> cpu_bursts(1, config.max_cpu_bursts);
+    uniform_int_distribution<int> priority(0, 9);
+
+    Workload workload;
+    workload.reserve(config.processes);
+    double arrival = 0;
+    for (int i = 0; i < config.processes; ++i) {
+        workload.add_process(i, priority(rng), (int)arrival);
+        arrival += config.arrival(rng);
+        int count = cpu_bursts(rng);
+        for (int b = 0; b < count; ++b) {
+            if (b > 0) workload.add_burst(burst_length(config.io(rng)));
+            workload.add_burst(burst_length(config.cpu(rng)));
+        }
+    }
+    return workload;
+}
+
+struct SweepStats {
+    double avg_wait, p99_wait, avg_turnaround, p99_turnaround;
+};
+
+double average(const vector<long> &values) {
+    double sum = 0;
+    for (long v : values) sum += v;
+    return values.empty() ? 0 : sum / values.size();
+}
+
+// Nearest rank: the smallest sample with at least a share q of the
+// samples at or below it
+double percentile(vector<long> &values, double q) {
+    if (values.empty()) return 0;
+    size_t rank = (size_t)ceil(q * values.size() - 1e-9);
+    size_t k = min(values.size() - 1, rank > 0 ? rank - 1 : 0);
+    nth_element(values.begin(), values.begin() + k, values.end());
+    return values[k];
+}
+
+// Runs every policy on every generated workload. Jobs (one workload under
+// one policy) are handed out to the worker threads through an atomic
+// counter and each job writes only its own result slot, so the workers
+// share nothing but the read-only workloads.
+void run_sweep(const SweepConfig &config, const MlfqConfig &mlfq) {
+    vector<Workload> workloads(config.workloads);
+    for (int i = 0; i < config.workloads; ++i) {
+        workloads[i] = generate_workload(config, config.seed + i);
+    }
+
+    size_t jobs = (size_t)config.workloads * POLICY_COUNT;
+    vector<vector<long>> waits(jobs), turnarounds(jobs);
+    atomic<size_t> next_job(0);
+    auto worker = [&]() {
+        for (size_t job; (job = next_job++) < jobs;) {
+            const Workload &workload = workloads[job / POLICY_COUNT];
+            Simulation sim(workload, POLICIES[job % POLICY_COUNT], mlfq);
+            sim.run();
+            for (int pid = 0; pid < workload.size(); ++pid) {
+                waits[job].push_back(sim.wait_time(pid));
+                turnarounds[job].push_back(sim.turnaround(pid));
+            }
+        }
+    };
+    vector<thread> pool;
+    for (int t = 0; t < config.threads; ++t) pool.emplace_back(worker);
+    for (auto &t : pool) t.join();
+
+    cout << config.workloads << " workloads x " << config.processes << " processes, seed "
+         << config.seed << ", " << config.threads << " threads" << endl;
+    cout << left << setw(10) << "policy" << right << setw(12) << "avg wait" << setw(12) << "p99 wait"
+         << setw(12) << "avg tat" << setw(12) << "p99 tat" << endl;
+    cout << fixed << setprecision(2);
+    for (int policy = 0; policy < POLICY_COUNT; ++policy) {
+        vector<long> wait, turnaround;
+        for (size_t job = policy; job < jobs; job += POLICY_COUNT) {
+            wait.insert(wait.end(), waits[job].begin(), waits[job].end());
+            turnaround.insert(turnaround.end(), turnarounds[job].begin(), turnarounds[job].end());
+        }
+        SweepStats stats = {average(wait), percentile(wait, 0.99),
+                            average(turnaround), percentile(turnaround, 0.99)};
+        cout << left << setw(10) << POLICY_NAMES[policy] << right
+             << setw(12) << stats.avg_wait << setw(12) << stats.p99_wait
+             << setw(12) << stats.avg_turnaround << setw(12) << stats.p99_turnaround << endl;
+    }
+}
+
+// Writes a workload in the proc.dat format read by read_input
+void write_workload(const Workload &workload, const string &path) {
+    ofstream file(path, ios::binary);
+    string line;
+    file << workload.size() << "\n";
+    for (int pid = 0; pid < workload.size(); ++pid) {
+        line = to_string(workload.id[pid]) + "," + to_string(workload.priority[pid]) + "," +
+               to_string(workload.arrival_time[pid]);
+        for (int b = 0; b < workload.burst_count[pid]; ++b) {
+            line += "," + to_string(workload.burst(pid, b));
+        }
+        line += ",-1\n";
+        file << line;
+    }
+}
+
+double seconds_since(chrono::steady_clock::time_point start) {
+    return chrono::duration<double>(chrono::steady_clock::now() - start).count();
+}
+
+// Inserts the policy name before the extension: out.json -> out.fcfs.json
+string policy_trace_path(const string &trace_path, int policy) {
+    size_t dot = trace_path.rfind('.');
+    if (dot == string::npos || trace_path.find('/', dot) != string::npos) dot = trace_path.size();
+    return trace_path.substr(0, dot) + "." + POLICY_NAMES[policy] + trace_path.substr(dot);
+}
+
+// Times loading a proc.dat and simulating it under every policy, and
+// writing each schedule as a Chrome trace, one file per policy, when
+// trace_path is set. Returns false if the input cannot be read or a trace
+// file cannot be written.
+bool run_bench(const string &path, const MlfqConfig &mlfq, const string &trace_path) {
+    auto start = chrono::steady_clock::now();
+    Workload workload;
+    if (!read_input(workload, path)) return false;
+    double load = seconds_since(start);
+    cout << "loaded " << workload.size() << " processes, " << workload.bursts.size()
+         << " bursts from " << path << endl;
+    cout << fixed << setprecision(3);
+    cout << left << setw(10) << "load" << right << setw(10) << load << " s" << endl;
+    for (int policy = 0; policy < POLICY_COUNT; ++policy) {
+        start = chrono::steady_clock::now();
+        Simulation sim(workload, POLICIES[policy], mlfq);
+        sim.run();
+        double elapsed = seconds_since(start);
+        cout << left << setw(10) << POLICY_NAMES[policy] << right << setw(10) << elapsed << " s";
+        if (!trace_path.empty()) {
+            start = chrono::steady_clock::now();
+            string policy_path = policy_trace_path(trace_path, policy);
+            ChromeTraceWriter trace(policy_path.c_str());
+            if (!trace.ok()) {
+                cout << endl;
+                cerr << "Cannot write " << policy_path << endl;
+                return false;
+            }
+            sim.write_trace(trace);
+            trace.close();
+            cout << ", trace " << seconds_since(start) << " s";
+        }
+        cout << endl;
+    }
+    return true;
+}
+
+// Usage: process [fcfs|sjf|priority|rr|mlfq] [from to] [--trace out.json]
+//                [--quanta q0,q1,...] [--boost interval]
+//        process --sweep [--workloads n] [--threads n] [--seed s]
+//                [--procs n] [--arrival dist] [--cpu dist] [--io dist]
+//                [--bursts max] [--quanta q0,q1,...] [--boost interval]
+//        process --generate n [file] [--seed s] [--arrival dist] [--cpu dist]
+//                [--io dist] [--bursts max]
+//        process --bench [file] [--trace out.json] [--quanta q0,q1,...]
+//                [--boost interval]
+// where dist is a mean, exponentially distributed, or exp:mean,
+// uniform:mean or fixed:mean. --bench writes out.<policy>.json per policy.
+int main(int argc, char **argv) {
+    string policy = "fcfs";
+    MlfqConfig config;
+    SweepConfig sweep;
+    bool sweeping = false, benchmarking = false;
+    long generate = 0;
+    string path = "proc.dat";
+    string trace_path;
+    vector<long> window;
+    bool distributions_ok = true;
+    for (int i = 1; i < argc; ++i) {
+        string arg = argv[i];
+        bool has_value = i + 1 < argc;
+        if (arg == "--quanta" && has_value) {
+            config.quanta = parse_list(argv[++i]);
+        } else if (arg == "--boost" && has_value) {
+            config.boost_interval = stol(argv[++i]);
+        } else if (arg == "--sweep") {
+            sweeping = true;
+        } else if (arg == "--generate" && has_value) {
+            generate = stol(argv[++i]);
+        } else if (arg == "--trace" && has_value) {
+            trace_path = argv[++i];
+        } else if (arg == "--bench") {
+            benchmarking = true;
+        } else if (arg == "--workloads" && has_value) {
+            sweep.workloads = stoi(argv[++i]);
+        } else if (arg == "--threads" && has_value) {
+            sweep.threads = stoi(argv[++i]);
+        } else if (arg == "--seed" && has_value) {
+            sweep.seed = stoull(argv[++i]);
+        } else if (arg == "--procs" && has_value) {
+            sweep.processes = stoi(argv[++i]);
+        } else if (arg == "--arrival" && has_value) {
+            distributions_ok &= parse_distribution(argv[++i], sweep.arrival);
+        } else if (arg == "--cpu" && has_value) {
+            distributions_ok &= parse_distribution(argv[++i], sweep.cpu);
+        } else if (arg == "--io" && has_value) {
+            distributions_ok &= parse_distribution(argv[++i], sweep.io);
+        } else if (arg == "--bursts" && has_value) {
+            sweep.max_cpu_bursts = stoi(argv[++i]);
+        } else if (isdigit((unsigned char)arg[0])) {
+            window.push_back(stol(arg));
+        } else if (generate > 0 || benchmarking) {
+            path = arg;
+        } else {
+            policy = arg;
+        }
+    }
+    if (config.quanta.empty() || config.quanta.size() > 64 || config.boost_interval <= 0 ||
+        *min_element(config.quanta.begin(), config.quanta.end()) <= 0) {
+        cerr << "MLFQ needs 1 to 64 positive quanta and a positive boost interval" << endl;
+        return 1;
+    }
+
+    if (!distributions_ok) {
+        cerr << "Distributions are exp, uniform or fixed" << endl;
+        return 1;
+    }
+    if (sweep.arrival.mean <= 0 || sweep.cpu.mean <= 0 || sweep.io.mean <= 0) {
+        cerr << "Distribution means must be positive" << endl;
+        return 1;
+    }
+
+    if (sweeping) {
+        if (sweep.workloads <= 0 || sweep.threads <= 0 || sweep.processes <= 0 || sweep.max_cpu_bursts <= 0) {
+            cerr << "Sweep counts must be positive" << endl;
+            return 1;
+        }
+        run_sweep(sweep, config);
+        return 0;
+    }
+    if (generate > 0) {
+        if (generate > INT_MAX) {
+            cerr << "Too many processes" << endl;
+            return 1;
+        }
+        sweep.processes = generate;
+        write_workload(generate_workload(sweep, sweep.seed), path);
+        return 0;
+    }
+    if (benchmarking) {
+        return run_bench(path, config, trace_path) ? 0 : 1;
+    }
+
+    Workload workload;
+    if (!read_input(workload)) return 1;
+    Simulation sim(workload, parse_policy(policy), config);
+    sim.run();
+    if (!trace_path.empty()) {
+        ChromeTraceWriter trace(trace_path.c_str());
+        if (!trace.ok()) {
+            cerr << "Cannot write " << trace_path << endl;
+            return 1;
+        }
+        sim.write_trace(trace);
+        return 0;
+    }
+    long from = window.size() > 0 ? window[0] : 0;
+    long to = window.size() > 1 ? window[1] : LONG_MAX;
+    sim.display_history(from, to);
+    return 0;
+}
@@ -1,9 +1,27 @@
 
 #include <iostream>
 #include <fstream>
+#include <sstream>
+#include <string>
 #include <vector>
 #include <queue>
 #include <iomanip>
+#include <algorithm>
+#include <cmath>
+#include <utility>
+#include <set>
+#include <map>
+#include <limits>
+#include <memory>
+#include <chrono>
+#include <thread>
+#include <mutex>
+#include <atomic>
+#ifdef __linux__
+#include <pthread.h>
+#include <sched.h>
+#endif
+#include "chrome_trace.h"
 
 
 struct Process {
@@ -11,8 +29,9 @@ struct Process {
    int processId;
    int burstTime;
    int priority;
-   int startTime;
-   int endTime;
+   double startTime;
+   double endTime;
+   int processor;
 
 
 
@@ -23,6 +42,24 @@ struct Process {
 };
 
 
+// How the single shared queue picks a processor for the next process:
+// the one that becomes free first, or the one that would finish it first
+// given its speed.
+enum class Placement { EarliestFree, EarliestFinish };
+
+
+// A process of burstTime units takes burstTime / speeds[k] on processor k.
+// The default is the original pair: Processor 1 twice as fast as Processor 2.
+// With work stealing, a process moved to another processor's queue starts
+// migrationCost time units after the thief picks it up.
+struct Machine {
+   std::vector<double> speeds = {2.0, 1.0};
+   Placement placement = Placement::EarliestFree;
+   bool workStealing = false;
+   double migrationCost = 0;
+};
+
+
 void readProcessData(const std::string &filename, std::vector<Process> &processes) {
    std::ifstream file(filename);
    if (!file) {
@@ -35,7 +72,7 @@ void readProcessData(const std::string &filename, std::vector<Process> &processe
    char comma;
    while (file >> arrival >> comma >> id >> comma >> burst >> comma >> priority) {
        if (arrival < 0) break;
-       processes.push_back({arrival, id, burst, priority, -1, -1});
+       processes.push_back({arrival, id, burst, priority, -1, -1, -1});
    }
    file.close();
 }
@@ -50,9 +87,11 @@ void printGanttChart(const std::vector<Process> &completed, const std::string &p
 }
 
 
+// Waiting time is the time spent queued, i.e. turnaround minus the time the
+// process actually ran on its processor.
 void calculateAndPrintStats(const std::vector<Process> &completed) {
-   int totalTurnaround = 0;
-   int totalWaiting = 0;
+   double totalTurnaround = 0;
+   double totalWaiting = 0;
 
 
    std::cout << "\nProcess-wise details:\n";
@@ -60,8 +99,8 @@ void calculateAndPrintStats(const std::vector<Process> &completed) {
 
 
    for (const auto &p : completed) {
-       int turnaroundTime = abs(p.endTime - p.arrivalTime);
-       int waitingTime = abs(turnaroundTime - p.burstTime);
+       double turnaroundTime = p.endTime - p.arrivalTime;
+       double waitingTime = turnaroundTime - (p.endTime - p.startTime);
 
 
        totalTurnaround += turnaroundTime;
@@ -74,115 +113,873 @@ void calculateAndPrintStats(const std::vector<Process> &completed) {
    }
 
 
-   std::cout << "\nAverage Turnaround Time: " << (totalTurnaround / (double)completed.size()) << "\n";
-   std::cout << "Average Waiting Time: " << (totalWaiting / (double)completed.size()) << "\n";
+   std::cout << "\nAverage Turnaround Time: " << (totalTurnaround / completed.size()) << "\n";
+   std::cout << "Average Waiting Time: " << (totalWaiting / completed.size()) << "\n";
 }
-void scheduleSingleQueue(const std::vector<Process> &processes) {
-   std::priority_queue<Process, std::vector<Process>, std::greater<Process>> queue;
-   std::vector<Process> completed;
-   int timeProcessor1 = 0, timeProcessor2 = 0;
 
 
-  
-   for (const auto &process : processes) {
-       queue.push(process);
+void runOn(Process &process, int processor, double freeTime, const Machine &machine) {
+   process.processor = processor;
+   process.startTime = std::max(freeTime, (double)process.arrivalTime);
+   process.endTime = process.startTime + process.burstTime / machine.speeds[processor];
+}
+
+
+struct ArrivalOrder {
+   bool operator()(const Process &a, const Process &b) const {
+       return a.arrivalTime > b.arrivalTime || (a.arrivalTime == b.arrivalTime && a.processId > b.processId);
    }
+};
 
 
-   while (!queue.empty()) {
-       Process current = queue.top();
-       queue.pop();
+using ReadyQueue = std::priority_queue<Process, std::vector<Process>, std::greater<Process>>;
+using FreeQueue = std::priority_queue<std::pair<double, int>, std::vector<std::pair<double, int>>,
+                                      std::greater<std::pair<double, int>>>;
+
+
+// Non-preemptive, event-driven dispatch of processes onto a set of
+// processors. Processes wait in an arrival-ordered heap and only enter the
+// ready heap once they have arrived, so a processor picks the most urgent
+// process among those present when it becomes free, and idles until the
+// next arrival when none are. Processor free times are kept in a min-heap,
+// so picking the earliest free processor is O(log n); earliest-finish
+// placement has to weigh each processor's speed and scans all of them.
+// Since earliest-finish may start a process later on a faster processor
+// that is still busy, the processes arriving by that start time are
+// admitted and the choice is made again until no more arrive, so a more
+// urgent late arrival is not overtaken.
+std::vector<Process> dispatch(const std::vector<Process> &processes, const std::vector<int> &processors,
+                              const Machine &machine) {
+   std::priority_queue<Process, std::vector<Process>, ArrivalOrder> arrivals(ArrivalOrder(), processes);
+   ReadyQueue ready;
+   std::vector<Process> completed;
+   std::vector<double> freeTime(machine.speeds.size(), 0);
+   FreeQueue freeProcessors;
+   for (int k : processors) {
+       freeProcessors.push({0, k});
+   }
 
 
-       if (timeProcessor1 <= timeProcessor2) {
-           current.startTime = std::max(timeProcessor1, current.arrivalTime);
-           current.endTime = current.startTime + current.burstTime / 2; // Processor 1 is twice as fast
-           timeProcessor1 = current.endTime;
-       } else {
-           current.startTime = std::max(timeProcessor2, current.arrivalTime);
-           current.endTime = current.startTime + current.burstTime; // Processor 2 speed
-           timeProcessor2 = current.endTime;
+   while (!arrivals.empty() || !ready.empty()) {
+       double now = freeProcessors.top().first;
+       if (machine.placement == Placement::EarliestFinish) {
+           now = freeTime[processors[0]];
+           for (int k : processors) now = std::min(now, freeTime[k]);
+       }
+       if (ready.empty()) now = std::max(now, (double)arrivals.top().arrivalTime);
+       while (!arrivals.empty() && arrivals.top().arrivalTime <= now) {
+           ready.push(arrivals.top());
+           arrivals.pop();
+       }
+
+
+       if (machine.placement == Placement::EarliestFree) {
+           Process current = ready.top();
+           ready.pop();
+           int processor = freeProcessors.top().second;
+           freeProcessors.pop();
+           runOn(current, processor, now, machine);
+           freeProcessors.push({current.endTime, processor});
+           completed.push_back(current);
+           continue;
        }
 
 
+       int best;
+       double bestStart = 0;
+       while (true) {
+           const Process &candidate = ready.top();
+           best = -1;
+           double bestEnd = 0;
+           for (int k : processors) {
+               double start = std::max({freeTime[k], now, (double)candidate.arrivalTime});
+               double end = start + candidate.burstTime / machine.speeds[k];
+               if (best < 0 || end < bestEnd) {
+                   best = k;
+                   bestStart = start;
+                   bestEnd = end;
+               }
+           }
+           if (arrivals.empty() || arrivals.top().arrivalTime > bestStart) break;
+           while (!arrivals.empty() && arrivals.top().arrivalTime <= bestStart) {
+               ready.push(arrivals.top());
+               arrivals.pop();
+           }
+       }
+       Process current = ready.top();
+       ready.pop();
+       runOn(current, best, std::max(freeTime[best], now), machine);
+       freeTime[best] = current.endTime;
+
+
        completed.push_back(current);
    }
+   return completed;
+}
+
+
+// Busy time is the time spent running processes; idle time is the rest of
+// the schedule, from time 0 to the last completion on any processor.
+void printUtilization(const std::vector<Process> &completed, const Machine &machine) {
+   int processorCount = machine.speeds.size();
+   std::vector<double> busy(processorCount, 0);
+   double makespan = 0;
+   for (const auto &p : completed) {
+       busy[p.processor] += p.endTime - p.startTime;
+       makespan = std::max(makespan, p.endTime);
+   }
 
 
-   printGanttChart(completed, "Single Queue (Both Processors)");
+   std::cout << "\nProcessor utilization over " << makespan << " time units:\n";
+   std::cout << "Processor | Speed | Busy Time | Idle Time | Utilization\n";
+   double totalBusy = 0;
+   for (int k = 0; k < processorCount; ++k) {
+       totalBusy += busy[k];
+       double utilization = makespan > 0 ? 100 * busy[k] / makespan : 0;
+       std::cout << std::setw(9) << k + 1 << " | " << std::setw(5) << machine.speeds[k]
+                 << " | " << std::setw(9) << busy[k] << " | " << std::setw(9) << makespan - busy[k]
+                 << " | " << std::setw(10) << utilization << "%\n";
+   }
+   double overall = makespan > 0 ? 100 * totalBusy / (makespan * processorCount) : 0;
+   std::cout << "Overall utilization: " << overall << "%, idle time: "
+             << makespan * processorCount - totalBusy << "\n";
+}
+
+
+// Writes one version's schedule as two track groups, one time unit per
+// microsecond: a track per processor with the processes it ran, and a track
+// per process with its waiting and running time.
+void traceSchedule(ChromeTraceWriter &trace, int version, const std::string &label,
+                   const std::vector<Process> &completed, const Machine &machine) {
+   int cpus = 2 * version - 1, tasks = 2 * version;
+   trace.process_name(cpus, (label + ": processors").c_str());
+   trace.process_name(tasks, (label + ": processes").c_str());
+   for (int k = 0; k < (int)machine.speeds.size(); ++k) {
+       trace.thread_name(cpus, k, "Processor ", k + 1);
+   }
+   for (const auto &p : completed) {
+       trace.thread_name(tasks, p.processId, "P", p.processId);
+       trace.slice(cpus, p.processor, "P", p.processId, p.startTime, p.endTime - p.startTime);
+       if (p.startTime > p.arrivalTime) {
+           trace.slice(tasks, p.processId, "Waiting", -1, p.arrivalTime, p.startTime - p.arrivalTime);
+       }
+       trace.slice(tasks, p.processId, "Running", -1, p.startTime, p.endTime - p.startTime);
+   }
+}
+
+
+void scheduleSingleQueue(const std::vector<Process> &processes, const Machine &machine, ChromeTraceWriter *trace) {
+   std::vector<int> processors(machine.speeds.size());
+   for (int k = 0; k < (int)processors.size(); ++k) {
+       processors[k] = k;
+   }
+   std::vector<Process> completed = dispatch(processes, processors, machine);
+
+
+   printGanttChart(completed, "Single Queue (All Processors)");
    calculateAndPrintStats(completed);
+   printUtilization(completed, machine);
+   if (trace) traceSchedule(*trace, 1, "Single Queue", completed, machine);
 }
 
 
-void scheduleTwoQueues(const std::vector<Process> &processes) {
-   std::priority_queue<Process, std::vector<Process>, std::greater<Process>> queue1, queue2;
-   std::vector<Process> completed1, completed2;
-   int timeProcessor1 = 0, timeProcessor2 = 0;
+// Priorities 1-10 are split into equal bands, one per processor, with the
+// most urgent band on Processor 1. With two processors this is the original
+// split at priority 5.
+int queueFor(int priority, int processorCount) {
+   int band = (priority - 1) * processorCount / 10;
+   return std::min(std::max(band, 0), processorCount - 1);
+}
 
 
+// Process indices in arrival order, ties in input order
+std::vector<int> arrivalOrder(const std::vector<Process> &processes) {
+   std::vector<int> order(processes.size());
+   for (int i = 0; i < (int)order.size(); ++i) order[i] = i;
+   std::stable_sort(order.begin(), order.end(), [&](int a, int b) {
+       return processes[a].arrivalTime < processes[b].arrivalTime;
+   });
+   return order;
+}
 
 
-   for (const auto &process : processes) {
-       if (process.priority <= 5) {
-           queue1.push(process);    // Higher priority for Processor 1
-       } else {
-           queue2.push(process);    // Lower priority for Processor 2
+// The separate queue of each process. Up to ten processors take the bands
+// of queueFor. With more, bands would leave most processors idle, so each
+// priority present gets its own group of processors instead, the most
+// urgent on the lowest-numbered ones, sized by its share of the processes
+// (at least one processor), and deals its processes round-robin over the
+// group in arrival order.
+std::vector<int> assignQueues(const std::vector<Process> &processes, int processorCount) {
+   std::vector<int> queue(processes.size());
+   if (processorCount <= 10) {
+       for (int i = 0; i < (int)processes.size(); ++i) {
+           queue[i] = queueFor(processes[i].priority, processorCount);
+       }
+       return queue;
+   }
+
+   std::map<int, std::vector<int>> levels;
+   for (int i : arrivalOrder(processes)) {
+       levels[processes[i].priority].push_back(i);
+   }
+   // Processors beyond one per level go by largest remainder
+   int spare = processorCount - levels.size(), left = spare;
+   std::vector<int> groupSize;
+   std::vector<std::pair<double, int>> remainders;
+   for (const auto &level : levels) {
+       double share = (double)spare * level.second.size() / processes.size();
+       groupSize.push_back(1 + (int)share);
+       left -= (int)share;
+       remainders.push_back({share - (int)share, (int)remainders.size()});
+   }
+   std::sort(remainders.begin(), remainders.end(), std::greater<std::pair<double, int>>());
+   for (int j = 0; j < left; ++j) {
+       groupSize[remainders[j].second]++;
+   }
+
+   int first = 0, group = 0;
+   for (const auto &level : levels) {
+       for (int j = 0; j < (int)level.second.size(); ++j) {
+           queue[level.second[j]] = first + j % groupSize[group];
+       }
+       first += groupSize[group++];
+   }
+   return queue;
+}
+
+
+void scheduleTwoQueues(const std::vector<Process> &processes, const Machine &machine, ChromeTraceWriter *trace) {
+   int processorCount = machine.speeds.size();
+   std::vector<std::vector<Process>> queued(processorCount);
+   std::vector<Process> all;
+   std::vector<int> queueOf = assignQueues(processes, processorCount);
+
+
+
+
+   for (int i = 0; i < (int)processes.size(); ++i) {
+       queued[queueOf[i]].push_back(processes[i]);
+   }
+
+
+
+
+   for (int k = 0; k < processorCount; ++k) {
+       if (queued[k].empty()) continue;
+       std::vector<Process> completed = dispatch(queued[k], {k}, machine);
+       printGanttChart(completed, "Processor " + std::to_string(k + 1));
+       calculateAndPrintStats(completed);
+       all.insert(all.end(), completed.begin(), completed.end());
+   }
+   printUtilization(all, machine);
+   if (trace) traceSchedule(*trace, 2, "Separate Queues", all, machine);
+}
+
+
+struct MoreUrgent {
+   bool operator()(const Process &a, const Process &b) const {
+       return b > a || (!(a > b) && a.processId < b.processId);
+   }
+};
+
+
+// Separate queues as in scheduleTwoQueues, but each processor's queue is
+// double-ended: the owner takes its most urgent process from the front,
+// and a processor that is idle with an empty queue steals the least urgent
+// process from the back of the longest queue of a busy processor. At each
+// event time every idle processor first serves its own queue, then the
+// ones still idle steal, so a processor never has work taken from it while
+// it could run it itself. Returns the completed processes per processor.
+std::vector<std::vector<Process>> stealingDispatch(const std::vector<Process> &processes, const Machine &machine,
+                                                   std::vector<int> &steals) {
+   int processorCount = machine.speeds.size();
+   std::vector<int> byArrival = arrivalOrder(processes);
+   std::vector<int> queueOf = assignQueues(processes, processorCount);
+   size_t arrived = 0;
+   std::vector<std::multiset<Process, MoreUrgent>> queues(processorCount);
+   std::vector<double> freeTime(processorCount, 0);
+   std::vector<std::vector<Process>> completed(processorCount);
+   steals.assign(processorCount, 0);
+   int remaining = processes.size();
+   double now = 0;
+
+
+   while (remaining > 0) {
+       while (arrived < byArrival.size() && processes[byArrival[arrived]].arrivalTime <= now) {
+           int i = byArrival[arrived++];
+           queues[queueOf[i]].insert(processes[i]);
+       }
+
+
+       for (int k = 0; k < processorCount; ++k) {
+           if (freeTime[k] > now || queues[k].empty()) continue;
+           Process current = *queues[k].begin();
+           queues[k].erase(queues[k].begin());
+           runOn(current, k, now, machine);
+           freeTime[k] = current.endTime;
+           completed[k].push_back(current);
+           remaining--;
+       }
+
+
+       for (int k = 0; k < processorCount; ++k) {
+           if (freeTime[k] > now) continue;
+           int victim = -1;
+           for (int j = 0; j < processorCount; ++j) {
+               if (!queues[j].empty() && (victim < 0 || queues[j].size() > queues[victim].size())) victim = j;
+           }
+           if (victim < 0) break;
+           auto last = std::prev(queues[victim].end());
+           Process current = *last;
+           queues[victim].erase(last);
+           runOn(current, k, now + machine.migrationCost, machine);
+           freeTime[k] = current.endTime;
+           completed[k].push_back(current);
+           steals[k]++;
+           remaining--;
+       }
+
+
+       double next = std::numeric_limits<double>::infinity();
+       if (arrived < byArrival.size()) next = processes[byArrival[arrived]].arrivalTime;
+       for (int k = 0; k < processorCount; ++k) {
+           if (freeTime[k] > now) next = std::min(next, freeTime[k]);
+       }
+       now = next;
+   }
+   return completed;
+}
+
+
+void scheduleWorkStealing(const std::vector<Process> &processes, const Machine &machine, ChromeTraceWriter *trace) {
+   int processorCount = machine.speeds.size();
+   std::vector<int> steals;
+   std::vector<std::vector<Process>> completed = stealingDispatch(processes, machine, steals);
+   std::vector<Process> all;
+   int totalSteals = 0;
+   for (int k = 0; k < processorCount; ++k) {
+       if (completed[k].empty()) continue;
+       printGanttChart(completed[k], "Processor " + std::to_string(k + 1));
+       calculateAndPrintStats(completed[k]);
+       std::cout << "Steals: " << steals[k] << "\n";
+       totalSteals += steals[k];
+       all.insert(all.end(), completed[k].begin(), completed[k].end());
+   }
+   printUtilization(all, machine);
+   if (trace) traceSchedule(*trace, 3, "Work Stealing", all, machine);
+   std::cout << "Total steals: " << totalSteals << ", migration time: "
+             << totalSteals * machine.migrationCost << "\n";
+}
+
+
+// Real execution of a workload: every process becomes a task that spins
+// for burstTime * unitUs / speed microseconds on a thread pinned to its own
+// CPU, one thread per processor. Tasks are released at their scaled arrival
+// times and the measured schedule is compared with the simulated one.
+enum class ExecutorMode { SharedQueue, PerCore, WorkStealing };
+
+
+const char *executorModeName(ExecutorMode mode) {
+   switch (mode) {
+   case ExecutorMode::SharedQueue: return "shared queue";
+   case ExecutorMode::PerCore: return "per-core queues";
+   default: return "work stealing";
+   }
+}
+
+
+using Clock = std::chrono::steady_clock;
+
+
+long long elapsedNs(Clock::time_point start) {
+   return std::chrono::duration_cast<std::chrono::nanoseconds>(Clock::now() - start).count();
+}
+
+
+// Nanosecond offsets from the start of the run. Each field is written by
+// exactly one thread and published through the queue the task goes through.
+struct TaskTiming {
+   long long released = 0, started = 0, finished = 0;
+   int worker = -1;
+};
+
+
+// Per-worker counters, padded so that workers never share a cache line.
+// For the locked queues contended counts lock acquisitions that had to
+// wait; for the lock-free deques it counts CAS races lost.
+struct alignas(64) WorkerStats {
+   long dispatches = 0;
+   long long dispatchNs = 0;
+   long acquisitions = 0;
+   long contended = 0;
+   long long lockWaitNs = 0;
+   long steals = 0;
+   long failedSteals = 0;
+};
+
+
+void lockCounted(std::mutex &lock, WorkerStats &stats, Clock::time_point start) {
+   stats.acquisitions++;
+   if (lock.try_lock()) return;
+   stats.contended++;
+   long long before = elapsedNs(start);
+   lock.lock();
+   stats.lockWaitNs += elapsedNs(start) - before;
+}
+
+
+// Mutex-protected ready heap of task indices, most urgent on top
+struct alignas(64) LockedQueue {
+   std::mutex lock;
+   std::vector<int> heap;
+};
+
+
+// Chase-Lev work-stealing deque of task indices. The owning worker pushes
+// and takes at the bottom (newest first) without locking; other workers
+// steal from the top (oldest first) with a single CAS. The ring is sized
+// for every task, so it never has to grow.
+class WorkStealingDeque {
+public:
+   explicit WorkStealingDeque(int tasks) {
+       int capacity = 1;
+       while (capacity <= tasks) capacity <<= 1;
+       buffer.reset(new std::atomic<int>[capacity]);
+       mask = capacity - 1;
+   }
+
+   void push(int task) {
+       long b = bottom.load(std::memory_order_relaxed);
+       buffer[b & mask].store(task, std::memory_order_relaxed);
+       std::atomic_thread_fence(std::memory_order_release);
+       bottom.store(b + 1, std::memory_order_relaxed);
+   }
+
+   bool take(int &task, WorkerStats &stats) {
+       long b = bottom.load(std::memory_order_relaxed) - 1;
+       bottom.store(b, std::memory_order_relaxed);
+       std::atomic_thread_fence(std::memory_order_seq_cst);
+       long t = top.load(std::memory_order_relaxed);
+       if (t > b) {
+           bottom.store(b + 1, std::memory_order_relaxed);
+           return false;
+       }
+       task = buffer[b & mask].load(std::memory_order_relaxed);
+       if (t == b) {
+           bool won = top.compare_exchange_strong(t, t + 1, std::memory_order_seq_cst, std::memory_order_relaxed);
+           bottom.store(b + 1, std::memory_order_relaxed);
+           if (!won) {
+               stats.contended++;
+               return false;
+           }
        }
+       return true;
    }
 
+   // Exact for the owner, since only the owner adds tasks
+   bool empty() const {
+       return top.load(std::memory_order_acquire) >= bottom.load(std::memory_order_relaxed);
+   }
+
+   bool steal(int &task, WorkerStats &stats) {
+       long t = top.load(std::memory_order_acquire);
+       std::atomic_thread_fence(std::memory_order_seq_cst);
+       long b = bottom.load(std::memory_order_acquire);
+       if (t >= b) return false;
+       task = buffer[t & mask].load(std::memory_order_relaxed);
+       if (!top.compare_exchange_strong(t, t + 1, std::memory_order_seq_cst, std::memory_order_relaxed)) {
+           stats.contended++;
+           return false;
+       }
+       return true;
+   }
 
+private:
+   alignas(64) std::atomic<long> top{0};
+   alignas(64) std::atomic<long> bottom{0};
+   std::unique_ptr<std::atomic<int>[]> buffer;
+   long mask;
+};
 
 
-   while (!queue1.empty()) {
-       Process current = queue1.top();
-       queue1.pop();
+void pinToCpu(std::thread &thread, int cpu) {
+#ifdef __linux__
+   cpu_set_t set;
+   CPU_ZERO(&set);
+   CPU_SET(cpu, &set);
+   pthread_setaffinity_np(thread.native_handle(), sizeof(set), &set);
+#else
+   (void)thread;
+   (void)cpu;
+#endif
+}
 
 
-       current.startTime = std::max(timeProcessor1, current.arrivalTime);
-       current.endTime = current.startTime + current.burstTime / 2;
-       timeProcessor1 = current.endTime;
+// Nearest rank: the smallest sample with at least a share q of the
+// samples at or below it
+double percentile(std::vector<double> values, double q) {
+   if (values.empty()) return 0;
+   size_t rank = (size_t)std::ceil(q * values.size() - 1e-9);
+   size_t k = std::min(values.size() - 1, rank > 0 ? rank - 1 : 0);
+   std::nth_element(values.begin(), values.begin() + k, values.end());
+   return values[k];
+}
 
 
-       completed1.push_back(current);
+// The simulator's schedule for the same dispatch policy, for comparison
+std::vector<Process> simulatedSchedule(const std::vector<Process> &processes, const Machine &machine,
+                                       ExecutorMode mode) {
+   int processorCount = machine.speeds.size();
+   std::vector<Process> completed;
+   if (mode == ExecutorMode::SharedQueue) {
+       std::vector<int> processors(processorCount);
+       for (int k = 0; k < processorCount; ++k) processors[k] = k;
+       return dispatch(processes, processors, machine);
    }
+   if (mode == ExecutorMode::PerCore) {
+       std::vector<std::vector<Process>> queued(processorCount);
+       std::vector<int> queueOf = assignQueues(processes, processorCount);
+       for (int i = 0; i < (int)processes.size(); ++i) {
+           queued[queueOf[i]].push_back(processes[i]);
+       }
+       for (int k = 0; k < processorCount; ++k) {
+           if (queued[k].empty()) continue;
+           std::vector<Process> done = dispatch(queued[k], {k}, machine);
+           completed.insert(completed.end(), done.begin(), done.end());
+       }
+       return completed;
+   }
+   std::vector<int> steals;
+   for (const auto &done : stealingDispatch(processes, machine, steals)) {
+       completed.insert(completed.end(), done.begin(), done.end());
+   }
+   return completed;
+}
 
 
-    while (!queue2.empty()) {
-       Process current = queue2.top();
-       queue2.pop();
+// Task indices ordered most urgent first, for a worker's private buffer
+struct TaskOrder {
+   const std::vector<Process> *processes;
+   bool operator()(int a, int b) const { return MoreUrgent()((*processes)[a], (*processes)[b]); }
+};
 
 
-       current.startTime = std::max(timeProcessor2, current.arrivalTime);
-       current.endTime = current.startTime + current.burstTime; // Processor 2 speed
-       timeProcessor2 = current.endTime;
+// Tasks a worker holds, published for thieves choosing a victim
+struct alignas(64) Backlog {
+   std::atomic<int> tasks{0};
+};
 
 
-       completed2.push_back(current);
+// Shared queue: one locked heap feeding every worker. Per-core queues: one
+// locked heap per worker, filled by priority band as in scheduleTwoQueues.
+// In both, the main thread releases tasks into the heaps at their arrival
+// times. Work stealing: each worker releases its own band's tasks, also
+// while a task is running, into a private buffer in priority order and
+// keeps only the least urgent of them in its Chase-Lev deque. The owner
+// runs the most urgent task it holds, and a worker with nothing to run
+// steals the exposed task of the worker holding the most, the same
+// discipline stealingDispatch simulates (apart from migration cost).
+void executeWorkload(const std::vector<Process> &processes, const Machine &machine, ExecutorMode mode,
+                     double unitUs) {
+   int workerCount = machine.speeds.size();
+   int taskCount = processes.size();
+   double unitNs = unitUs * 1000;
+   std::vector<TaskTiming> timing(taskCount);
+   std::vector<WorkerStats> stats(workerCount + 1);
+   WorkerStats &releaserStats = stats[workerCount];
+
+   std::vector<int> byArrival = arrivalOrder(processes);
+   std::vector<int> queueOf = assignQueues(processes, workerCount);
+   auto moreUrgentLast = [&](int a, int b) { return processes[a] > processes[b]; };
+   auto releaseTime = [&](int task) { return (long long)(processes[task].arrivalTime * unitNs); };
+
+   std::vector<LockedQueue> queues(mode == ExecutorMode::SharedQueue ? 1 : workerCount);
+   std::vector<std::unique_ptr<WorkStealingDeque>> deques;
+   std::vector<std::vector<int>> pending(workerCount);
+   std::vector<std::multiset<int, TaskOrder>> buffers(workerCount, std::multiset<int, TaskOrder>(TaskOrder{&processes}));
+   std::vector<Backlog> backlogs(workerCount);
+   for (int k = 0; k < workerCount; ++k) {
+       deques.emplace_back(new WorkStealingDeque(taskCount));
+   }
+   for (int task : byArrival) {
+       pending[queueOf[task]].push_back(task);
    }
 
+   std::atomic<bool> go(false);
+   std::atomic<int> done(0);
+   Clock::time_point start;
+
+   auto worker = [&](int k) {
+       WorkerStats &mine = stats[k];
+       std::multiset<int, TaskOrder> &buffer = buffers[k];
+       int exposed = -1;
+       size_t nextPending = 0;
+       // Refills the deque with the least urgent buffered task once the
+       // previous one has been taken or stolen
+       auto expose = [&]() {
+           if (exposed >= 0 && !deques[k]->empty()) return;
+           exposed = -1;
+           if (!buffer.empty()) {
+               auto last = std::prev(buffer.end());
+               exposed = *last;
+               buffer.erase(last);
+               deques[k]->push(exposed);
+           }
+           backlogs[k].tasks.store(buffer.size() + (exposed >= 0), std::memory_order_relaxed);
+       };
+       auto releaseDue = [&]() {
+           while (nextPending < pending[k].size() && releaseTime(pending[k][nextPending]) <= elapsedNs(start)) {
+               int task = pending[k][nextPending++];
+               timing[task].released = elapsedNs(start);
+               buffer.insert(task);
+           }
+           expose();
+       };
+       while (!go.load(std::memory_order_acquire)) {
+       }
 
-   printGanttChart(completed1, "Processor 1");
-   calculateAndPrintStats(completed1);
+       while (done.load(std::memory_order_acquire) < taskCount) {
+           long long before = elapsedNs(start);
+           int task = -1;
+           if (mode == ExecutorMode::WorkStealing) {
+               releaseDue();
+               before = elapsedNs(start);
+               if (exposed >= 0 && (buffer.empty() || MoreUrgent()(processes[exposed], processes[*buffer.begin()]))) {
+                   if (!deques[k]->take(task, mine)) task = -1;
+                   exposed = -1;
+               }
+               if (task < 0 && !buffer.empty()) {
+                   task = *buffer.begin();
+                   buffer.erase(buffer.begin());
+               }
+               expose();
+               if (task < 0) {
+                   int victim = -1, most = 0;
+                   for (int j = 0; j < workerCount; ++j) {
+                       int held = backlogs[j].tasks.load(std::memory_order_relaxed);
+                       if (j != k && held > most) {
+                           victim = j;
+                           most = held;
+                       }
+                   }
+                   if (victim >= 0 && deques[victim]->steal(task, mine)) {
+                       mine.steals++;
+                   } else {
+                       task = -1;
+                       if (victim >= 0) mine.failedSteals++;
+                   }
+               }
+           } else {
+               LockedQueue &queue = queues[mode == ExecutorMode::SharedQueue ? 0 : k];
+               lockCounted(queue.lock, mine, start);
+               if (!queue.heap.empty()) {
+                   std::pop_heap(queue.heap.begin(), queue.heap.end(), moreUrgentLast);
+                   task = queue.heap.back();
+                   queue.heap.pop_back();
+               }
+               queue.lock.unlock();
+           }
+           if (task < 0) {
+               std::this_thread::yield();
+               continue;
+           }
+
+           TaskTiming &t = timing[task];
+           t.started = elapsedNs(start);
+           mine.dispatchNs += t.started - before;
+           mine.dispatches++;
+           t.worker = k;
+           long long end = t.started + (long long)(processes[task].burstTime * unitNs / machine.speeds[k]);
+           while (elapsedNs(start) < end) {
+               if (mode == ExecutorMode::WorkStealing) releaseDue();
+           }
+           t.finished = elapsedNs(start);
+           done.fetch_add(1, std::memory_order_release);
+       }
+   };
+
+   std::vector<std::thread> pool;
+   unsigned cpus = std::max(1u, std::thread::hardware_concurrency());
+   for (int k = 0; k < workerCount; ++k) {
+       pool.emplace_back(worker, k);
+       pinToCpu(pool.back(), k % cpus);
+   }
+   start = Clock::now();
+   go.store(true, std::memory_order_release);
+
+   if (mode != ExecutorMode::WorkStealing) {
+       for (int task : byArrival) {
+           while (elapsedNs(start) < releaseTime(task)) std::this_thread::yield();
+           LockedQueue &queue = queues[mode == ExecutorMode::SharedQueue ? 0 : queueOf[task]];
+           lockCounted(queue.lock, releaserStats, start);
+           timing[task].released = elapsedNs(start);
+           queue.heap.push_back(task);
+           std::push_heap(queue.heap.begin(), queue.heap.end(), moreUrgentLast);
+           queue.lock.unlock();
+       }
+   }
+   for (auto &thread : pool) thread.join();
 
 
-   printGanttChart(completed2, "Processor 2");
-   calculateAndPrintStats(completed2);
+   std::vector<double> turnaround, delay;
+   double makespan = 0;
+   for (int task = 0; task < taskCount; ++task) {
+       turnaround.push_back((timing[task].finished - releaseTime(task)) / 1000.0);
+       delay.push_back((timing[task].started - timing[task].released) / 1000.0);
+       makespan = std::max(makespan, timing[task].finished / 1000.0);
+   }
+   double simulatedMakespan = 0, simulatedTurnaround = 0;
+   std::vector<double> simulated;
+   for (const auto &p : simulatedSchedule(processes, machine, mode)) {
+       simulatedMakespan = std::max(simulatedMakespan, p.endTime * unitUs);
+       simulatedTurnaround += (p.endTime - p.arrivalTime) * unitUs;
+       simulated.push_back((p.endTime - p.arrivalTime) * unitUs);
+   }
+   WorkerStats total;
+   for (const auto &s : stats) {
+       total.dispatches += s.dispatches;
+       total.dispatchNs += s.dispatchNs;
+       total.acquisitions += s.acquisitions;
+       total.contended += s.contended;
+       total.lockWaitNs += s.lockWaitNs;
+       total.steals += s.steals;
+       total.failedSteals += s.failedSteals;
+   }
+   double sum = 0;
+   for (double t : turnaround) sum += t;
+
+
+   std::cout << "\nExecutor: " << executorModeName(mode) << ", " << workerCount << " pinned workers, "
+             << unitUs << " us per time unit\n";
+   std::cout << "Makespan (us): measured " << makespan << ", simulated " << simulatedMakespan << "\n";
+   std::cout << "Turnaround (us): average " << sum / taskCount << " (simulated " << simulatedTurnaround / taskCount
+             << "), p50 " << percentile(turnaround, 0.5) << " (" << percentile(simulated, 0.5) << "), p99 "
+             << percentile(turnaround, 0.99) << " (" << percentile(simulated, 0.99) << "), max "
+             << percentile(turnaround, 1) << " (" << percentile(simulated, 1) << ")\n";
+   std::cout << "Queueing delay (us): p50 " << percentile(delay, 0.5) << ", p99 " << percentile(delay, 0.99)
+             << ", max " << percentile(delay, 1) << "\n";
+   std::cout << "Dispatch overhead: " << (total.dispatches ? total.dispatchNs / (double)total.dispatches : 0)
+             << " ns per task\n";
+   if (mode == ExecutorMode::WorkStealing) {
+       std::cout << "Contention: " << total.contended << " CAS races lost, " << total.steals << " steals, "
+                 << total.failedSteals << " empty or lost steal attempts\n";
+   } else {
+       std::cout << "Contention: " << total.contended << " of " << total.acquisitions
+                 << " lock acquisitions waited, " << total.lockWaitNs / 1000.0 << " us waiting\n";
+   }
 }
 
 
+// Parses a speed list such as "2,1" or "2x32,1x32", where "x n" repeats a
+// speed for n processors.
+std::vector<double> parseSpeeds(const std::string &text) {
+   std::vector<double> speeds;
+   std::stringstream ss(text);
+   std::string token;
+   while (std::getline(ss, token, ',')) {
+       size_t x = token.find('x');
+       double speed = std::stod(token.substr(0, x));
+       int count = x == std::string::npos ? 1 : std::max(std::stoi(token.substr(x + 1)), 0);
+       speeds.insert(speeds.end(), count, speed);
+   }
+   return speeds;
+}
+
+
+// Usage: twoprocessor [file] [--speeds s1,s2,...] [--placement free|finish]
+//                     [--steal migration-cost]
+//                     [--execute shared|percore|steal|all] [--unit-us us]
+//                     [--trace out.json]
+// The separate queues of Versions 2 and 3 split priorities 1-10 into one
+// band per processor. With more than ten processors, each priority present
+// gets a group of processors sized by its share of the processes instead.
+int main(int argc, char **argv) {
+   std::string filename = "sched2.dat";
+   Machine machine;
+   std::string execute, tracePath;
+   double unitUs = 1000;
+   for (int i = 1; i < argc; ++i) {
+       std::string arg = argv[i];
+       if (arg == "--speeds" && i + 1 < argc) {
+           machine.speeds = parseSpeeds(argv[++i]);
+       } else if (arg == "--placement" && i + 1 < argc) {
+           std::string placement = argv[++i];
+           machine.placement = placement == "finish" ? Placement::EarliestFinish : Placement::EarliestFree;
+       } else if (arg == "--trace" && i + 1 < argc) {
+           tracePath = argv[++i];
+       } else if (arg == "--execute" && i + 1 < argc) {
+           execute = argv[++i];
+       } else if (arg == "--unit-us" && i + 1 < argc) {
+           unitUs = std::stod(argv[++i]);
+       } else if (arg == "--steal" && i + 1 < argc) {
+           machine.workStealing = true;
+           machine.migrationCost = std::stod(argv[++i]);
+       } else {
+           filename = arg;
+       }
+   }
+   for (double speed : machine.speeds) {
+       if (!(speed > 0)) machine.speeds.clear();
+   }
+   if (machine.speeds.empty()) {
+       std::cerr << "Processor speeds must be positive" << std::endl;
+       return 1;
+   }
+   if (machine.migrationCost < 0) {
+       std::cerr << "Migration cost must not be negative" << std::endl;
+       return 1;
+   }
 
 
-int main() {
    std::vector<Process> processes;
-   readProcessData("sched2.dat", processes);
+   readProcessData(filename, processes);
+   if (processes.empty()) return 0;
+
+
+   if (!execute.empty()) {
+       if (!(unitUs > 0)) {
+           std::cerr << "Time unit must be positive" << std::endl;
+           return 1;
+       }
+       const std::pair<const char *, ExecutorMode> modes[] = {{"shared", ExecutorMode::SharedQueue},
+                                                              {"percore", ExecutorMode::PerCore},
+                                                              {"steal", ExecutorMode::WorkStealing}};
+       bool ran = false;
+       for (const auto &[name, mode] : modes) {
+           if (execute != "all" && execute != name) continue;
+           executeWorkload(processes, machine, mode, unitUs);
+           ran = true;
+       }
+       if (!ran) {
+           std::cerr << "Unknown executor mode: " << execute << std::endl;
+           return 1;
+       }
+       return 0;
+   }
+
+
+   std::unique_ptr<ChromeTraceWriter> trace;
+   if (!tracePath.empty()) {
+       trace.reset(new ChromeTraceWriter(tracePath.c_str()));
+       if (!trace->ok()) {
+           std::cerr << "Cannot write " << tracePath << std::endl;
+           return 1;
+       }
+   }
 
 
    std::cout << "Version 1: Single Queue Scheduling\n";
-   scheduleSingleQueue(processes);
+   scheduleSingleQueue(processes, machine, trace.get());
 
 
    std::cout << "\nVersion 2: Separate Queue Scheduling\n";
-   scheduleTwoQueues(processes);
+   scheduleTwoQueues(processes, machine, trace.get());
+
+
+   if (machine.workStealing) {
+       std::cout << "\nVersion 3: Separate Queues with Work Stealing\n";
+       scheduleWorkStealing(processes, machine, trace.get());
+   }
 
 
    return 0;